@@ -10,13 +10,36 @@
 // - ARGP_ASSERT - assert function
 // - ARGP_REALLOC - realloc function
 // - ARGP_LIST_INIT_CAP - initial capacity of argp list
+// - ARGP_SORTED_BLOCK - entries per front-coded block of sorted lists
+// - ARGP_SNAPSHOT_MAGIC - magic number written at the start of snapshots
+// - ARGP_NO_THREADS - validate paths on the calling thread only
+// - ARGP_IO_URING - stat paths in io_uring batches when the kernel supports it, see argp_uring_stat_paths
+// - ARGP_THREAD_COUNT - maximum number of threads used to validate paths and convert lists
+// - ARGP_PARALLEL_MIN - entries below which a parallel list is converted on the calling thread
+// - ARGP_CPU_COUNT - cores parallel work may use, the ones online by default
+// - ARGP_RCU_READER_CAP - how many reader threads can be registered for live reload
+// - ARGP_ERROR_CAP - how many errors a parse with .collect_errors records
+// - ARGP_PROBE - statement run for every slot a name or map lookup visits, e.g. to count them
+// - ARGP_MINIMAL - smallest footprint: commands and bool, uint, str, enum, enum set and list
+//   arguments only, no help flag, usage, error printing, dump, path checks, lazy flags, nargs,
+//   bind, error collection, snapshots or live reload, descriptions and meta variables are not
+//   stored, the options of the features left out do not exist, implies ARGP_NO_THREADS
 #ifndef ARGPARSE_H
 #define ARGPARSE_H
 
+// the implementation uses POSIX functions such as fileno, which a strict -std=c11 hides unless
+// a feature test macro is defined before the first system header, so _GNU_SOURCE is defined
+// here for the case where this header comes first
+#if defined(ARGPARSE_IMPLEMENTATION) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#ifndef ARGP_MINIMAL
 #include <stdio.h>
+#endif
 
 typedef enum {
     ARGP_OPTIONAL = false,
@@ -24,33 +47,226 @@ typedef enum {
     ARGP_APPEAR_REQUIRED,
 } Argp_Required;
 
+typedef enum {
+    ARGP_BOOL,
+    ARGP_UINT,
+    ARGP_STR,
+    ARGP_ENUM,
+    ARGP_ENUM_SET,
+    ARGP_LIST,
+    ARGP_MAP,
+    ARGP_RANGES,
+    ARGP_UINT_LIST,
+    ARGP_ENUM_LIST,
+    ARGP_SORTED_LIST,
+    ARGP_TYPE_COUNT,
+} Argp_Type;
+
+typedef enum {
+    ARGP_NO_ERROR = 0,
+    ARGP_ERROR_UNKNOWN,
+    ARGP_ERROR_UNKNOWN_ENUM,
+    ARGP_ERROR_NO_VALUE,
+    ARGP_ERROR_INVALID_NUMBER,
+    ARGP_ERROR_INTEGER_OVERFLOW,
+    ARGP_ERROR_ALLOC,
+    ARGP_ERROR_INVALID_ENTRY,
+    ARGP_ERROR_DUPLICATE_KEY,
+    ARGP_ERROR_PATH_NOT_FOUND,
+    ARGP_ERROR_PATH_NOT_FILE,
+    ARGP_ERROR_PATH_NOT_DIR,
+    ARGP_ERROR_PATH_NOT_READABLE,
+    ARGP_ERROR_PATH_LOOP,
+    ARGP_ERROR_PATH_TOO_LONG,
+    ARGP_ERROR_PATH_IO,
+    ARGP_ERROR_INVALID_RANGE,
+    ARGP_ERROR_RANGE_OVERLAP,
+    ARGP_ERROR_SNAPSHOT,
+    ARGP_ERROR_COUNT,
+} Argp_Error;
+
+typedef enum {
+    ARGP_SOURCE_DEFAULT,
+    ARGP_SOURCE_ARGV,
+    ARGP_SOURCE_SNAPSHOT,
+} Argp_Source;
+
 typedef struct {
     char **items;
     size_t size;
     size_t _cap;
 } Argp_List;
 
+#ifndef ARGP_MINIMAL
+// values of uint lists, indices into the options for enum lists
+typedef struct {
+    uint64_t *items;
+    size_t size;
+    size_t _cap;
+} Argp_Uint_List;
+
+typedef struct {
+    char *key;
+    char *value;
+} Argp_Map_Entry;
+
+// open addressing table, entries with a NULL key are empty
+typedef struct {
+    Argp_Map_Entry *items;
+    size_t size;
+    size_t _cap;
+} Argp_Map;
+
+// inclusive
+typedef struct {
+    uint64_t lo;
+    uint64_t hi;
+} Argp_Range;
+
+// sorted, non-overlapping and non-adjacent ranges
+typedef struct {
+    Argp_Range *items;
+    size_t size;
+    size_t _cap;
+} Argp_Ranges;
+
+// iterates every value of a range set, initialize with (Argp_Ranges_Iter){.ranges = r}
+typedef struct {
+    const Argp_Ranges *ranges;
+    size_t _index;
+    uint64_t _next;
+    bool _started;
+} Argp_Ranges_Iter;
+
+#ifndef ARGP_SORTED_BLOCK
+#define ARGP_SORTED_BLOCK 16
+#endif
+
+// sorted and deduplicated strings, front-coded in blocks of ARGP_SORTED_BLOCK entries:
+// the first entry of a block is stored whole, the others as the length of the prefix
+// shared with the previous entry followed by the rest of the entry
+typedef struct {
+    char *_data;     // offset of every block followed by the blocks
+    size_t count;    // entries
+    size_t max_len;  // length of the longest entry
+} Argp_Sorted_List;
+
+// iterates the entries in order, initialize with (Argp_Sorted_Iter){.list = l, .buf = buf}
+// where buf holds at least l->max_len + 1 bytes, every entry is decoded into buf
+typedef struct {
+    const Argp_Sorted_List *list;
+    char *buf;
+    size_t _index;
+    const char *_at;
+} Argp_Sorted_Iter;
+
+typedef enum {
+    ARGP_MAP_LAST_WINS,
+    ARGP_MAP_UNIQUE,
+} Argp_Map_Dup;
+#endif  // ARGP_MINIMAL
+
 typedef struct {
     const char *desc;
     bool help;
+#ifndef ARGP_MINIMAL
+    bool help_search;     // add --help-search TERM to the program, see argp_help_search
+    bool strict;          // convert lazy flags while parsing, as if they were not lazy
+    bool collect_errors;  // keep parsing after recoverable errors, see argp_error_records
+#endif
 } Argp_Opt;
 
+#ifndef ARGP_MINIMAL
+// an error found while parsing, see argp_error_records
+typedef struct {
+    Argp_Error code;
+    int argv_index;          // of the offending token, -1 if it is not in argv
+    const char *short_name;  // flag the error belongs to, both NULL if none
+    const char *long_name;
+    const char *pos_name;    // positional argument the error belongs to, NULL if none
+    const char *token;       // offending token, NULL if none
+    size_t index;            // entry of a list or range set, SIZE_MAX if not applicable
+    const char **options;    // expected values of an enum argument, NULL otherwise
+    size_t option_count;
+} Argp_Error_Record;
+#endif
+
+typedef enum {
+    ARGP_KIND_COMMAND,
+    ARGP_KIND_FLAG,
+    ARGP_KIND_POS,
+} Argp_Kind;
+
+// describes the argument owning a returned value
+typedef struct {
+    Argp_Kind kind;
+    Argp_Type type;
+    const char *name;
+    const char *desc;
+    const bool *command;  // NULL for the program itself
+    const void *def;      // points to the same type as the value, NULL for commands
+    bool set;
+    Argp_Source source;
+} Argp_Info;
+
+// .bind option: where to copy an argument's value in a caller-owned struct, see argp_bind
+// the member must have the type the argp_* function returns a pointer to
+#define ARGP_BIND(type, member) (offsetof(type, member) + 1)
+
 typedef struct {
     const char *desc;
     bool help;
     const bool *command;
+#ifndef ARGP_MINIMAL
+    size_t bind;  // ARGP_BIND(type, member)
+#endif
 } Argp_Command_Opt;
 
+#ifndef ARGP_MINIMAL
+// checks applied to the values of str and list arguments after parsing
+typedef enum {
+    ARGP_PATH_EXISTS = 1 << 0,
+    ARGP_PATH_FILE = 1 << 1,
+    ARGP_PATH_DIR = 1 << 2,
+    ARGP_PATH_READABLE = 1 << 3,
+} Argp_Path_Check;
+#endif
+
 typedef struct {
     const char *desc;
     const char *meta_var;
     const bool *command;
+#ifndef ARGP_MINIMAL
+    unsigned path;  // Argp_Path_Check flags
+    bool lazy;      // uint and enum: keep the token and convert it on first read, see argp_get_uint
+    size_t bind;    // ARGP_BIND(type, member)
+#endif
 } Argp_Flag_Opt;
 
+#ifndef ARGP_MINIMAL
+// how many tokens a positional argument takes, like nargs in Python argparse
+// {0, 0} keeps the default: one token, or any number for lists, at least one if required
+typedef struct {
+    size_t min;
+    size_t max;
+} Argp_Nargs;
+
+#define ARGP_NARGS(n) ((Argp_Nargs){(n), (n)})
+#define ARGP_NARGS_OPTIONAL ((Argp_Nargs){0, 1})    // ?
+#define ARGP_NARGS_ANY ((Argp_Nargs){0, SIZE_MAX})  // *
+#define ARGP_NARGS_SOME ((Argp_Nargs){1, SIZE_MAX}) // +
+#endif
+
 typedef struct {
     const char *desc;
     Argp_Required req;
     const bool *command;
+#ifndef ARGP_MINIMAL
+    unsigned path;      // Argp_Path_Check flags
+    bool parallel;      // uint and enum lists: convert the entries on the worker pool after parsing
+    Argp_Nargs nargs;   // more than one token only for list types
+    size_t bind;        // ARGP_BIND(type, member)
+#endif
 } Argp_Pos_Opt;
 
 #define argp_init(argc, argv, ...) \
@@ -60,6 +276,11 @@ void argp_init_(int argc, char **argv, Argp_Opt opt);
 // returns name of flag given its return value
 const char *argp_name(void *val);
 
+// fills info for the argument given its return value in constant time, a lazy flag is
+// resolved first and a failed conversion is left in argp_error()
+// returns false if val was not returned by this library
+bool argp_info(const void *val, Argp_Info *info);
+
 // Command Arguments
 
 #define argp_command(name, ...) \
@@ -67,6 +288,8 @@ const char *argp_name(void *val);
 bool *argp_command_(const char *name, Argp_Command_Opt opt);
 
 // Flag Arguments
+//
+// A long flag that takes a value also accepts it in the same token, as in --name=value
 
 #define argp_flag_bool(short_name, long_name, ...) \
     argp_flag_bool_(short_name, long_name, (Argp_Flag_Opt){__VA_ARGS__})
@@ -88,10 +311,40 @@ char **argp_flag_str_(const char *short_name, const char *long_name, char *def,
 size_t *argp_flag_enum_(const char *short_name, const char *long_name, const char *options[],
                         size_t option_count, size_t def, Argp_Flag_Opt opt);
 
+// stores a bit for each option given as a comma-separated list, e.g. --enable=a,b
+// repeating the flag adds to the set, option_count must be at most 64
+#define argp_flag_enum_set(short_name, long_name, options, option_count, def, ...) \
+    argp_flag_enum_set_(short_name, long_name, options, option_count,              \
+                        def, (Argp_Flag_Opt){__VA_ARGS__})
+uint64_t *argp_flag_enum_set_(const char *short_name, const char *long_name, const char *options[],
+                              size_t option_count, uint64_t def, Argp_Flag_Opt opt);
+
 #define argp_flag_list(short_name, long_name, ...) \
     argp_flag_list_(short_name, long_name, (Argp_Flag_Opt){__VA_ARGS__})
 Argp_List *argp_flag_list_(const char *short_name, const char *long_name, Argp_Flag_Opt opt);
 
+#ifndef ARGP_MINIMAL
+// entries are given as key=value, they are split in place and not copied
+// dup specifies whether a repeated key replaces the value or is an error
+#define argp_flag_map(short_name, long_name, dup, ...) \
+    argp_flag_map_(short_name, long_name, dup, (Argp_Flag_Opt){__VA_ARGS__})
+Argp_Map *argp_flag_map_(const char *short_name, const char *long_name, Argp_Map_Dup dup,
+                         Argp_Flag_Opt opt);
+
+// integer ranges given as a comma-separated list, e.g. --cpus 0-63,128,200-255
+// repeating the flag adds to the set, overlapping ranges are an error reported for the one given later,
+// the set is built once the whole command line is read
+#define argp_flag_ranges(short_name, long_name, ...) \
+    argp_flag_ranges_(short_name, long_name, (Argp_Flag_Opt){__VA_ARGS__})
+Argp_Ranges *argp_flag_ranges_(const char *short_name, const char *long_name, Argp_Flag_Opt opt);
+
+// entries are sorted and deduplicated once parsing ends, see Argp_Sorted_List
+// an argument @file adds every line of file, @- every line of standard input, @@x adds @x
+#define argp_flag_sorted_list(short_name, long_name, ...) \
+    argp_flag_sorted_list_(short_name, long_name, (Argp_Flag_Opt){__VA_ARGS__})
+Argp_Sorted_List *argp_flag_sorted_list_(const char *short_name, const char *long_name, Argp_Flag_Opt opt);
+#endif  // ARGP_MINIMAL
+
 // Positional Arguments
 
 #define argp_pos_uint(name, def, ...) \
@@ -107,26 +360,259 @@ char **argp_pos_str_(const char *name, char *def, Argp_Pos_Opt opt);
 size_t *argp_pos_enum_(const char *name, const char *options[], size_t option_count,
                        size_t def, Argp_Pos_Opt opt);
 
-// NOTE: must be placed as the last positional argument
+// tokens are shared between positional arguments as in Python argparse: each takes as
+// many as it can while leaving enough for the minimum of the ones after it
 #define argp_pos_list(name, ...) \
     argp_pos_list_(name, (Argp_Pos_Opt){__VA_ARGS__})
 Argp_List *argp_pos_list_(const char *name, Argp_Pos_Opt opt);
 
+#ifndef ARGP_MINIMAL
+#define argp_pos_uint_list(name, ...) \
+    argp_pos_uint_list_(name, (Argp_Pos_Opt){__VA_ARGS__})
+Argp_Uint_List *argp_pos_uint_list_(const char *name, Argp_Pos_Opt opt);
+
+#define argp_pos_enum_list(name, options, option_count, ...) \
+    argp_pos_enum_list_(name, options, option_count, (Argp_Pos_Opt){__VA_ARGS__})
+Argp_Uint_List *argp_pos_enum_list_(const char *name, const char *options[], size_t option_count,
+                                    Argp_Pos_Opt opt);
+
+#define argp_pos_ranges(name, ...) \
+    argp_pos_ranges_(name, (Argp_Pos_Opt){__VA_ARGS__})
+Argp_Ranges *argp_pos_ranges_(const char *name, Argp_Pos_Opt opt);
+
+#define argp_pos_sorted_list(name, ...) \
+    argp_pos_sorted_list_(name, (Argp_Pos_Opt){__VA_ARGS__})
+Argp_Sorted_List *argp_pos_sorted_list_(const char *name, Argp_Pos_Opt opt);
+
+#endif  // ARGP_MINIMAL
+
 void argp_free_list(Argp_List *list);
 
+#ifndef ARGP_MINIMAL
+void argp_free_uint_list(Argp_Uint_List *list);
+
+// returns value of key or NULL if it is not present
+char *argp_map_get(const Argp_Map *map, const char *key);
+void argp_free_map(Argp_Map *map);
+
+bool argp_ranges_contains(const Argp_Ranges *ranges, uint64_t v);
+bool argp_ranges_next(Argp_Ranges_Iter *it, uint64_t *v);
+// returns a bitmap of word_count words with bit v set for every v in ranges,
+// allocated with ARGP_REALLOC, NULL if ranges is empty or allocation fails
+uint64_t *argp_ranges_bitmap(const Argp_Ranges *ranges, size_t *word_count);
+void argp_free_ranges(Argp_Ranges *ranges);
+
+size_t argp_sorted_block_count(const Argp_Sorted_List *list);
+// moves the iterator to the first entry of a block, past the end for block_count
+void argp_sorted_seek(Argp_Sorted_Iter *it, size_t block);
+// decodes the next entry into it->buf, returns false after the last one
+bool argp_sorted_next(Argp_Sorted_Iter *it);
+// decodes the entry at index into buf, which holds at least list->max_len + 1 bytes
+bool argp_sorted_get(const Argp_Sorted_List *list, size_t index, char *buf);
+// binary search over the blocks, then a scan of one block without decoding it
+bool argp_sorted_contains(const Argp_Sorted_List *list, const char *s);
+void argp_free_sorted_list(Argp_Sorted_List *list);
+#endif  // ARGP_MINIMAL
+
 bool argp_parse_args(void);
 
+// like argp_parse_args, but unknown options, positional arguments that have no place and
+// everything after -- are passed through instead of being errors
+// they are compacted in place into the argv given to argp_init, right after argv[0],
+// no string is copied and the result is NULL terminated so it can be given to execvp
+bool argp_parse_known_args(int *argc, char ***argv);
+
+// error of the last failed call, ARGP_NO_ERROR if there was none
+Argp_Error argp_error(void);
+
+#ifndef ARGP_MINIMAL
+// copies the value of every argument declared with .bind into base, now and after every
+// successful parse or reload, so the values end up in one struct owned by the caller
+// strings, lists, maps and ranges are copied shallowly and borrow from the values of the
+// last good parse, they stay valid until a later reload succeeds, a failed one binds the
+// previous values again
+// returns false if a bound lazy flag fails to convert
+bool argp_bind(void *base);
+
+// converts the token of a lazy flag given its return value, the result is cached
+// the value holds the default until then, returns false and sets the error if it is invalid
+// not thread safe, resolve before sharing the value with other threads
+bool argp_resolve(const void *val);
+
+// read a uint or enum argument given its return value, resolving it first if it is lazy
+// an invalid token reads as the default and sets the error, same threading rule as argp_resolve
+uint64_t argp_get_uint(const uint64_t *val);
+size_t argp_get_enum(const size_t *val);
+
+// errors of the last parse with .collect_errors in argv order, errors not tied to a token last
+// flag values, positional arguments, unknown options and paths are checked past the first
+// error, allocation failures stop the parse
+// returns how many were recorded, at most ARGP_ERROR_CAP, *total gets how many were found
+size_t argp_error_records(const Argp_Error_Record **records, size_t *total);
+
 void argp_print_usage(FILE *stream);
 void argp_print_error(FILE *stream);
 
+// prints the commands, flags and positional arguments of the whole tree matching term with
+// their full command path, best match first, and returns how many matched
+// names, descriptions, enum options and command names are searched for term as a word,
+// a word prefix or a substring, ignoring case
+size_t argp_help_search(FILE *stream, const char *term);
+
+typedef enum {
+    ARGP_DUMP_TEXT,
+    ARGP_DUMP_JSON,
+} Argp_Dump_Format;
+
+// writes the selected command path and the value of every argument on it
+// the output is formatted in memory and written to the descriptor of stream with a single
+// write(2), retried only for what a partial write left
+bool argp_dump(FILE *stream, Argp_Dump_Format format);
+
+// Snapshots
+//
+// Serializes every parsed value into a position-independent blob so that a child
+// process which registered the same arguments can load it instead of parsing.
+// Loading fails if the blob was written by a different argument spec or names an enum
+// option that does not exist.
+// Loading frees the lists, maps and snapshot buffer it replaces, strings loaded from a
+// snapshot point into a buffer that lives until the next load.
+
+bool argp_snapshot_write(int fd);
+bool argp_snapshot_load(int fd);
+
+// Live Reload
+//
+// argp_publish copies the parsed values into an immutable generation and makes it current
+// with a single atomic swap. Reader threads get the current generation with argp_current and
+// look values up with argp_get, the values they get are never modified.
+//
+// Readers register with argp_rcu_register and call argp_rcu_quiescent whenever they hold no
+// generation, e.g. between requests. A replaced generation is freed once every registered
+// reader has been quiescent since the swap.
+//
+// Publishing and reloading must happen on a single thread, e.g. the main loop that sees
+// SIGHUP, not inside the signal handler. The values returned by argp_flag_* and argp_pos_*
+// are scratch space for reloads and must not be read by other threads.
+//
+// The first call to argp_reload takes ownership of every value, the lists, maps and ranges of
+// the first parse included, whether or not it succeeds: they must not be freed with argp_free_*
+// from then on. A value is freed once a reload has replaced it, the rest by the next argp_init.
+
+typedef struct Argp_Generation Argp_Generation;
+
+typedef struct {
+    uint64_t _epoch;
+} Argp_Rcu_Reader;
+
+bool argp_publish(void);
+
+// resets every argument to its default, parses argv and publishes the result
+// argv[0] is skipped, it need not match the name given to argp_init
+// argv must stay valid until a later reload succeeds
+// on failure the values of the last good parse are put back and bound again, and the current
+// generation stays published
+bool argp_reload(int argc, char **argv);
+
+// reloads from the whitespace separated arguments in path, # starts a comment
+bool argp_reload_file(const char *path);
+
+// a single acquire load, NULL before the first argp_publish
+const Argp_Generation *argp_current(void);
+
+// value of the argument given its handle in gen, points to the same type as the handle
+const void *argp_get(const Argp_Generation *gen, const void *handle);
+
+// returns false if ARGP_RCU_READER_CAP readers are already registered
+bool argp_rcu_register(Argp_Rcu_Reader *reader);
+void argp_rcu_unregister(Argp_Rcu_Reader *reader);
+void argp_rcu_quiescent(Argp_Rcu_Reader *reader);
+
+// frees replaced generations that no reader can hold anymore, also done by every publish
+void argp_rcu_reclaim(void);
+
+#ifdef __linux__
+// returns a non-blocking inotify descriptor that becomes readable when path is written or
+// replaced, or -1 on failure, the directory is watched so editors that rename are seen
+int argp_reload_watch(const char *path);
+
+// drains fd and reloads path if it changed
+// returns false only if a reload was attempted and failed
+bool argp_reload_watch_handle(int fd, const char *path);
+#endif
+#elif defined(__GNUC__)
+// printing is left out of the minimal build, calls fail to compile rather than to link
+#define ARGP_NOT_MINIMAL(name) __attribute__((error(name " is not available with ARGP_MINIMAL, use argp_error()")))
+void argp_print_usage(void *stream) ARGP_NOT_MINIMAL("argp_print_usage");
+void argp_print_error(void *stream) ARGP_NOT_MINIMAL("argp_print_error");
+#endif  // ARGP_MINIMAL
+
 #endif  // ARGPARSE_H
 
 #ifdef ARGPARSE_IMPLEMENTATION
 
+#include <ctype.h>
 #include <errno.h>
 #include <limits.h>
+#include <stdarg.h>
 #include <stdlib.h>
+#include <fcntl.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+// statx is called through syscall with the struct from the kernel headers, so it is found
+// whether or not _GNU_SOURCE was in effect when <sys/stat.h> was first included
+#if defined(__linux__) && !defined(ARGP_MINIMAL)
+#include <sys/syscall.h>
+#if !defined(STATX_TYPE) && defined(__has_include)
+#if __has_include(<linux/stat.h>)
+#include <linux/stat.h>
+#endif
+#endif
+#if defined(STATX_TYPE) && defined(SYS_statx)
+#define ARGP_HAVE_STATX
+#endif
+#endif
+
+// IO_URING_OP_SUPPORTED comes with the probe that tells whether the kernel runs statx on a ring,
+// and the headers that have it have statx
+#if defined(ARGP_HAVE_STATX) && defined(ARGP_IO_URING) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#if defined(IO_URING_OP_SUPPORTED) && defined(SYS_io_uring_setup)
+#define ARGP_HAVE_IO_URING
+#endif
+#endif
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<sys/random.h>)
+#include <sys/random.h>
+#define ARGP_HAVE_GETRANDOM
+#endif
+#endif
+
+// numbers are converted with std::from_chars when the implementation is built as C++17
+#if defined(__cplusplus) && __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#define ARGP_HAVE_FROM_CHARS
+#endif
+#endif
+
+#if defined(ARGP_MINIMAL) && !defined(ARGP_NO_THREADS)
+#define ARGP_NO_THREADS
+#endif
+
+#ifndef ARGP_NO_THREADS
+#include <pthread.h>
+#endif
 
 #ifndef ARGP_FLAG_CAP
 #define ARGP_FLAG_CAP 128
@@ -148,47 +634,87 @@ void argp_print_error(FILE *stream);
 #define ARGP_LIST_INIT_CAP 6
 #endif
 
+#ifndef ARGP_SNAPSHOT_MAGIC
+#define ARGP_SNAPSHOT_MAGIC 0x50524741u  // "ARGP"
+#endif
+
+#ifndef ARGP_THREAD_COUNT
+#define ARGP_THREAD_COUNT 8
+#endif
+
+#ifndef ARGP_CPU_COUNT
+#define ARGP_CPU_COUNT sysconf(_SC_NPROCESSORS_ONLN)
+#endif
+
+// below this, handing work to the pool costs more than it saves, see make bench
+#ifndef ARGP_PARALLEL_MIN
+#define ARGP_PARALLEL_MIN 32768
+#endif
+
+#ifdef PATH_MAX
+#define ARGP_PATH_MAX PATH_MAX
+#else
+#define ARGP_PATH_MAX 4096
+#endif
+
+#ifndef ARGP_RCU_READER_CAP
+#define ARGP_RCU_READER_CAP 64
+#endif
+
+#ifndef ARGP_ERROR_CAP
+#define ARGP_ERROR_CAP 32
+#endif
+
 #ifndef ARGP_ASSERT
+#ifdef ARGP_MINIMAL
+#define ARGP_ASSERT(cond) ((cond) ? (void)0 : abort())
+#else
 #include <assert.h>
 #define ARGP_ASSERT assert
 #endif
+#endif
+
+// zero value of a struct, {0} warns about missing initializers in C++
+#ifdef __cplusplus
+#define ARGP_ZERO(type) type{}
+#else
+#define ARGP_ZERO(type) (type){0}
+#endif
+
+// usage and error printing only run once, keep them away from the parse path
+#ifdef __GNUC__
+#define ARGP_COLD __attribute__((cold))
+#else
+#define ARGP_COLD
+#endif
 
 #ifndef ARGP_REALLOC
 #include <stdlib.h>
 #define ARGP_REALLOC realloc
 #endif
 
+#ifndef ARGP_PROBE
+#define ARGP_PROBE() ((void)0)
+#endif
+
 #ifndef ARGP_FREE
 #include <stdlib.h>
 #define ARGP_FREE free
 #endif
 
-typedef enum {
-    ARGP_BOOL,
-    ARGP_UINT,
-    ARGP_STR,
-    ARGP_ENUM,
-    ARGP_LIST,
-    ARGP_TYPE_COUNT,
-} Argp_Type;
-
-typedef enum {
-    ARGP_NO_ERROR = 0,
-    ARGP_ERROR_UNKNOWN,
-    ARGP_ERROR_UNKNOWN_ENUM,
-    ARGP_ERROR_NO_VALUE,
-    ARGP_ERROR_INVALID_NUMBER,
-    ARGP_ERROR_INTEGER_OVERFLOW,
-    ARGP_ERROR_ALLOC,
-    ARGP_ERROR_COUNT,
-} Argp_Error;
-
 typedef union {
     bool as_bool;
     uint64_t as_uint;
     char *as_str;
     size_t as_enum;
+    uint64_t as_enum_set;
     Argp_List as_list;
+#ifndef ARGP_MINIMAL
+    Argp_Map as_map;
+    Argp_Ranges as_ranges;
+    Argp_Uint_List as_uint_list;
+    Argp_Sorted_List as_sorted;
+#endif
 } Argp_Value;
 
 typedef struct Argp_Flag Argp_Flag;
@@ -198,8 +724,11 @@ typedef struct Argp_Command Argp_Command;
 struct Argp_Command {
     bool val;
     const char *name;
+#ifndef ARGP_MINIMAL
+    size_t bind;
     const char *desc;
     Argp_Flag *help_flag;
+#endif
     const Argp_Command *parent_command;
 
     size_t pos_count;
@@ -217,13 +746,25 @@ struct Argp_Flag {
     const char *short_name;
     const char *long_name;
 
+#ifndef ARGP_MINIMAL
     const char *meta_var;
     const char *desc;
+#endif
 
     const char **enum_options;
     size_t option_count;
+#ifndef ARGP_MINIMAL
+    Argp_Map_Dup map_dup;
+    unsigned path_check;
+
+    bool lazy;
+    char *raw;          // token waiting for conversion
+    Argp_List raw_list; // entries of a sorted list waiting to be encoded
+    size_t bind;
+#endif
 
     const Argp_Command *command;
+    Argp_Source source;
 };
 
 struct Argp_Pos {
@@ -232,16 +773,85 @@ struct Argp_Pos {
 
     Argp_Type type;
     const char *name;
+#ifndef ARGP_MINIMAL
     const char *desc;
+#endif
     Argp_Required req;
 
     const char **enum_options;
     size_t option_count;
+#ifndef ARGP_MINIMAL
+    unsigned path_check;
+
+    bool parallel;
+    Argp_List raw;  // tokens waiting for parallel conversion or sorting
+    Argp_Nargs nargs;
+    size_t bind;
+#endif
 
     const Argp_Command *command;
-    bool seen;
+    Argp_Source source;
+};
+
+#ifndef ARGP_MINIMAL
+typedef struct {
+    size_t text;   // offset of the lowercased word in the index text
+    size_t entry;  // commands, then flags, then positional arguments
+    int weight;    // how much a match in this field counts
+} Argp_Search_Word;
+
+// words of every argument, built on the first search and again when arguments are added
+typedef struct {
+    char *text;
+    size_t text_size;
+    size_t text_cap;
+    Argp_Search_Word *words;
+    size_t word_count;
+    size_t word_cap;
+    size_t entry_count;
+} Argp_Search_Index;
+#endif
+
+// what an entry of the name table names
+enum {
+    ARGP_NAME_SHORT,
+    ARGP_NAME_LONG,
+    ARGP_NAME_COMMAND,
+    ARGP_NAME_OPTION,
 };
 
+typedef struct {
+    const char *name;   // NULL for an empty slot
+    const void *scope;  // command of a flag, parent of a command, flag or positional of an enum option
+    unsigned kind;
+    size_t index;       // into flags or commands, or of the enum option
+} Argp_Name;
+
+// open addressing table of every name a token is looked up by,
+// built on the first parse and again when arguments are added
+typedef struct {
+    Argp_Name *items;
+    size_t cap;          // power of two, at least twice the names
+    size_t entry_count;  // commands, flags and positional arguments it was built for
+} Argp_Names;
+
+typedef struct {
+    char *arg;
+    int pass_at;     // pass_argc when it was read, keeps passthrough order in argp_parse_known_args
+    int argv_index;
+} Argp_Pos_Token;
+
+#ifndef ARGP_MINIMAL
+// an entry of a range argument, queued until the parse is done
+typedef struct {
+    Argp_Range r;
+    Argp_Ranges *ranges;  // set it goes into
+    const char *token;    // argument it was read from
+    size_t index;         // position in the argument
+    size_t seq;           // order in which the entries were read
+} Argp_Range_Entry;
+#endif
+
 typedef struct {
     size_t flag_capacity;
     Argp_Flag flags[ARGP_FLAG_CAP];
@@ -261,18 +871,69 @@ typedef struct {
     Argp_Flag *err_flag;
     Argp_Pos *err_pos;
     const char *unknown_option;
+    size_t err_index;
+    int err_argv_index;  // -1 when the token is looked up in argv
+
+#ifndef ARGP_MINIMAL
+    bool collect;
+    Argp_Error_Record errors[ARGP_ERROR_CAP];
+    size_t error_count;
+    size_t error_total;
+#endif
 
     int rest_argc;
     char **rest_argv;
+    char *inline_value;  // value of the current --name=value token
+
+    char **argv;
+    int pass_argc;  // tokens passed through are written to argv[1..pass_argc)
+
+    char **parse_argv;  // argv of the current parse
+    int parse_argc;
+
+    Argp_Pos_Token *pos_tokens;  // positional tokens of the current command
+    size_t pos_token_count;
+    size_t pos_token_cap;
 
     Argp_Command *program_command;
     Argp_Command *command_ctx;
+
+    Argp_Names names;
+    uint64_t seed;  // of the name table and maps
+
+#ifndef ARGP_MINIMAL
+    Argp_Range_Entry *range_entries;  // the buffer is kept between parses
+    size_t range_entry_count;
+    size_t range_entry_cap;
+
+    char *snapshot;
+
+    Argp_Generation *generation;  // accessed atomically
+    Argp_Generation *retired;
+    uint64_t epoch;               // accessed atomically
+    Argp_Rcu_Reader *readers[ARGP_RCU_READER_CAP];
+    bool owns_values;             // set by argp_reload, the library frees the values
+    bool strict;
+    char *bind_base;
+    Argp_Flag *help_search_flag;
+    Argp_Search_Index search;
+    Argp_List ingested;           // buffers read for @file entries, freed once lists are encoded
+    char *reload_data;            // file the values were reloaded from
+    char **reload_argv;
+    char *reload_failed_data;     // file of the last failed reload, the error points into it
+    char **reload_failed_argv;
+#endif
 } Argp_Ctx;
 
 static Argp_Ctx argp_global_ctx;
 
 static char *shift_args(void) {
     Argp_Ctx *c = &argp_global_ctx;
+    if (c->inline_value) {
+        char *res = c->inline_value;
+        c->inline_value = NULL;
+        return res;
+    }
     if (c->rest_argc == 0) return NULL;
     char *res = c->rest_argv[0];
     --c->rest_argc;
@@ -280,6 +941,158 @@ static char *shift_args(void) {
     return res;
 }
 
+static uint64_t argp_hash_bytes(uint64_t h, const void *data, size_t n) {
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= p[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+#ifndef ARGP_MINIMAL
+static uint64_t argp_hash_u64(uint64_t h, uint64_t v) {
+    return argp_hash_bytes(h, &v, sizeof(v));
+}
+
+static uint64_t argp_hash_str(uint64_t h, const char *s) {
+    if (!s) return argp_hash_u64(h, UINT64_MAX);
+    return argp_hash_bytes(h, s, strlen(s) + 1);
+}
+#endif
+
+// spreads every input bit over the low bits used to index tables
+static uint64_t argp_hash_mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+// unpredictable, so names and map keys can't be chosen to collide ahead of time
+static uint64_t argp_random_seed(void) {
+    uint64_t seed;
+#ifdef ARGP_HAVE_GETRANDOM
+    if (getrandom(&seed, sizeof(seed), GRND_NONBLOCK) == (ssize_t)sizeof(seed)) return seed;
+#endif
+    int flags = O_RDONLY;
+#ifdef O_CLOEXEC
+    flags |= O_CLOEXEC;
+#endif
+    int fd = open("/dev/urandom", flags);
+    if (fd >= 0) {
+        ssize_t n = read(fd, &seed, sizeof(seed));
+        close(fd);
+        if (n == (ssize_t)sizeof(seed)) return seed;
+    }
+
+    // no entropy source, still differs between processes with ASLR
+    uint64_t local = 0;
+    return argp_hash_mix((uint64_t)(uintptr_t)&local ^ (uint64_t)(uintptr_t)&argp_global_ctx << 17 ^ (uint64_t)getpid());
+}
+
+// positional types that take every remaining positional argument
+static bool argp_is_list(Argp_Type type) {
+    return type == ARGP_LIST || type == ARGP_UINT_LIST || type == ARGP_ENUM_LIST ||
+           type == ARGP_SORTED_LIST;
+}
+
+// effective number of tokens a positional argument takes
+static void argp_pos_nargs(const Argp_Pos *pos, size_t *min, size_t *max) {
+#ifndef ARGP_MINIMAL
+    if (pos->nargs.max) {
+        ARGP_ASSERT(pos->nargs.min <= pos->nargs.max);
+        ARGP_ASSERT((argp_is_list(pos->type) || pos->nargs.max == 1) && "only lists take several tokens");
+        *min = pos->nargs.min;
+        *max = pos->nargs.max;
+        return;
+    }
+#endif
+    *min = pos->req == ARGP_REQUIRED;
+    *max = argp_is_list(pos->type) ? SIZE_MAX : 1;
+}
+
+// every value returned to the user is the first member of its flag, positional or command,
+// so its index follows from its offset into the corresponding array
+static bool argp_find_index(const void *val, const void *base, size_t size, size_t count,
+                            size_t *index) {
+    uintptr_t p = (uintptr_t)val, b = (uintptr_t)base;
+    if (p < b || p >= b + size * count || (p - b) % size != 0) return false;
+    *index = (p - b) / size;
+    return true;
+}
+
+#ifndef ARGP_MINIMAL
+// the current error as a record
+static Argp_Error_Record argp_error_record(void) {
+    Argp_Ctx *c = &argp_global_ctx;
+    Argp_Error_Record r = ARGP_ZERO(Argp_Error_Record);
+    r.code = c->err;
+    r.argv_index = c->err_argv_index;
+    r.token = c->unknown_option;
+    r.index = SIZE_MAX;
+
+    // the token itself or a part of it, as for --flag=value
+    for (int i = 0; r.argv_index < 0 && r.token && i < c->parse_argc; ++i) {
+        const char *arg = c->parse_argv[i];
+        if (r.token >= arg && r.token <= arg + strlen(arg)) r.argv_index = i;
+    }
+
+    Argp_Type type;
+    const char **options;
+    size_t option_count;
+    if (c->err_flag) {
+        r.short_name = c->err_flag->short_name;
+        r.long_name = c->err_flag->long_name;
+        type = c->err_flag->type;
+        options = c->err_flag->enum_options;
+        option_count = c->err_flag->option_count;
+    } else if (c->err_pos) {
+        r.pos_name = c->err_pos->name;
+        type = c->err_pos->type;
+        options = c->err_pos->enum_options;
+        option_count = c->err_pos->option_count;
+    } else {
+        return r;
+    }
+
+    // index into the list for path errors, index of the comma-separated entry for ranges
+    if ((type == ARGP_LIST && c->err >= ARGP_ERROR_PATH_NOT_FOUND && c->err <= ARGP_ERROR_PATH_IO) ||
+        type == ARGP_RANGES || type == ARGP_UINT_LIST || type == ARGP_ENUM_LIST)
+        r.index = c->err_index;
+
+    if (type == ARGP_ENUM || type == ARGP_ENUM_SET || type == ARGP_ENUM_LIST) {
+        r.options = options;
+        r.option_count = option_count;
+    }
+    return r;
+}
+#endif
+
+// records the current error and clears it so the parse can go on,
+// false if errors are not collected or the parse can't go on
+static bool argp_collect_error(void) {
+#ifdef ARGP_MINIMAL
+    return false;
+#else
+    Argp_Ctx *c = &argp_global_ctx;
+    if (!c->collect || c->err == ARGP_ERROR_ALLOC) return false;
+
+    if (c->error_count < ARGP_ERROR_CAP) c->errors[c->error_count++] = argp_error_record();
+    ++c->error_total;
+
+    c->err = ARGP_NO_ERROR;
+    c->err_flag = NULL;
+    c->err_pos = NULL;
+    c->unknown_option = NULL;
+    c->err_index = 0;
+    c->err_argv_index = -1;
+    return true;
+#endif
+}
+
 static Argp_Flag *argp_new_flag(Argp_Type type, const char *short_name, const char *long_name,
                                 const char *meta_var, const char *desc, Argp_Command *command) {
     ARGP_ASSERT(short_name != NULL || long_name != NULL);
@@ -289,14 +1102,17 @@ static Argp_Flag *argp_new_flag(Argp_Type type, const char *short_name, const ch
     Argp_Flag *flag = c->flags + (c->flag_capacity++);
     command = command ? command : c->program_command;
 
-    *flag = (Argp_Flag){
-        .type = type,
-        .short_name = short_name,
-        .long_name = long_name,
-        .meta_var = meta_var,
-        .desc = desc,
-        .command = command,
-    };
+    *flag = ARGP_ZERO(Argp_Flag);
+    flag->type = type;
+    flag->short_name = short_name;
+    flag->long_name = long_name;
+#ifndef ARGP_MINIMAL
+    flag->meta_var = meta_var;
+    flag->desc = desc;
+#endif
+    flag->command = command;
+    (void)meta_var;
+    (void)desc;
 
     ++command->flag_count;
     return flag;
@@ -312,13 +1128,15 @@ static Argp_Pos *argp_new_pos(Argp_Type type, const char *name, const char *desc
     Argp_Pos *pos = c->poss + (c->pos_capacity++);
     command = command ? command : c->program_command;
 
-    *pos = (Argp_Pos){
-        .type = type,
-        .name = name,
-        .desc = desc,
-        .req = req,
-        .command = command,
-    };
+    *pos = ARGP_ZERO(Argp_Pos);
+    pos->type = type;
+    pos->name = name;
+#ifndef ARGP_MINIMAL
+    pos->desc = desc;
+#endif
+    pos->req = req;
+    pos->command = command;
+    (void)desc;
 
     ++command->pos_count;
     return pos;
@@ -333,13 +1151,17 @@ bool *argp_command_(const char *name, Argp_Command_Opt opt) {
     Argp_Command *command = c->commands + (c->command_capacity++);
     Argp_Command *parent_command = opt.command ? (Argp_Command *)opt.command : c->program_command;
 
-    *command = (Argp_Command){
-        .name = name,
-        .desc = opt.desc,
-        .parent_command = parent_command,
-    };
+    *command = ARGP_ZERO(Argp_Command);
+    command->name = name;
+#ifndef ARGP_MINIMAL
+    command->bind = opt.bind;
+    command->desc = opt.desc;
+#endif
+    command->parent_command = parent_command;
+#ifndef ARGP_MINIMAL
     if (opt.help)
         command->help_flag = argp_new_flag(ARGP_BOOL, "h", "help", NULL, "show this help message and exit", command);
+#endif
 
     if (parent_command)
         ++parent_command->command_count;
@@ -347,24 +1169,71 @@ bool *argp_command_(const char *name, Argp_Command_Opt opt) {
     return &command->val;
 }
 
-static void print_full_command_name(FILE *stream, const Argp_Command *command) {
+#ifndef ARGP_MINIMAL
+static int print_full_command_name(FILE *stream, const Argp_Command *command) {
+    int width = 0;
     if (command->parent_command)
-        print_full_command_name(stream, command->parent_command);
-    fprintf(stream, " %s", command->name);
+        width += print_full_command_name(stream, command->parent_command);
+    return width + fprintf(stream, " %s", command->name);
 }
+#endif
+
+static void argp_release(void);
 
 void argp_init_(int argc, char **argv, Argp_Opt opt) {
     Argp_Ctx *c = &argp_global_ctx;
 
-    *c = (Argp_Ctx){0};
+    // a previous spec is replaced
+    argp_release();
+    *c = ARGP_ZERO(Argp_Ctx);
 
+    c->err_argv_index = -1;
     c->rest_argc = argc;
     c->rest_argv = argv;
+    c->argv = argv;
+    c->seed = argp_random_seed();
+
+#ifndef ARGP_MINIMAL
+    c->strict = opt.strict;
+    c->collect = opt.collect_errors;
+#endif
 
-    c->program_command = (Argp_Command *)argp_command_(argv[0], (Argp_Command_Opt){.desc = opt.desc, .help = opt.help});
+    Argp_Command_Opt program = ARGP_ZERO(Argp_Command_Opt);
+    program.desc = opt.desc;
+    program.help = opt.help;
+    c->program_command = (Argp_Command *)argp_command_(argv[0], program);
+#ifndef ARGP_MINIMAL
+    if (opt.help_search)
+        c->help_search_flag = argp_new_flag(ARGP_STR, NULL, "help-search", "TERM",
+                                            "list the arguments matching TERM and exit", c->program_command);
+#endif
     c->command_ctx = NULL;
 }
 
+// stores the options that only apply to some types
+static void argp_flag_opt(Argp_Flag *flag, Argp_Flag_Opt opt) {
+#ifndef ARGP_MINIMAL
+    flag->bind = opt.bind;
+    if (flag->type == ARGP_STR || flag->type == ARGP_LIST) flag->path_check = opt.path;
+    if (flag->type == ARGP_UINT || flag->type == ARGP_ENUM) flag->lazy = opt.lazy;
+#else
+    (void)flag;
+    (void)opt;
+#endif
+}
+
+static void argp_pos_opt(Argp_Pos *pos, Argp_Pos_Opt opt) {
+#ifndef ARGP_MINIMAL
+    pos->bind = opt.bind;
+    pos->nargs = opt.nargs;
+    if (pos->type == ARGP_STR || pos->type == ARGP_LIST) pos->path_check = opt.path;
+    if (pos->type == ARGP_UINT_LIST || pos->type == ARGP_ENUM_LIST) pos->parallel = opt.parallel;
+#else
+    (void)pos;
+    (void)opt;
+#endif
+}
+
 bool *argp_flag_bool_(const char *short_name, const char *long_name, Argp_Flag_Opt opt) {
     Argp_Flag *flag = argp_new_flag(
         ARGP_BOOL,
@@ -373,12 +1242,14 @@ bool *argp_flag_bool_(const char *short_name, const char *long_name, Argp_Flag_O
         NULL,
         opt.desc,
         (Argp_Command *)opt.command);
+    argp_flag_opt(flag, opt);
     return &flag->val.as_bool;
 }
 
 uint64_t *argp_flag_uint_(const char *short_name, const char *long_name, uint64_t def, Argp_Flag_Opt opt) {
     Argp_Flag *flag = argp_new_flag(ARGP_UINT, short_name, long_name,
                                     opt.meta_var, opt.desc, (Argp_Command *)opt.command);
+    argp_flag_opt(flag, opt);
     flag->val.as_uint = def;
     flag->def.as_uint = def;
     return &flag->val.as_uint;
@@ -387,6 +1258,7 @@ uint64_t *argp_flag_uint_(const char *short_name, const char *long_name, uint64_
 char **argp_flag_str_(const char *short_name, const char *long_name, char *def, Argp_Flag_Opt opt) {
     Argp_Flag *flag = argp_new_flag(ARGP_STR, short_name, long_name,
                                     opt.meta_var, opt.desc, (Argp_Command *)opt.command);
+    argp_flag_opt(flag, opt);
     flag->val.as_str = def;
     flag->def.as_str = def;
     return &flag->val.as_str;
@@ -396,6 +1268,7 @@ size_t *argp_flag_enum_(const char *short_name, const char *long_name, const cha
                         size_t option_count, size_t def, Argp_Flag_Opt opt) {
     Argp_Flag *flag = argp_new_flag(ARGP_ENUM, short_name, long_name, NULL, opt.desc,
                                     (Argp_Command *)opt.command);
+    argp_flag_opt(flag, opt);
     flag->val.as_enum = def;
     flag->def.as_enum = def;
     flag->enum_options = options;
@@ -403,17 +1276,63 @@ size_t *argp_flag_enum_(const char *short_name, const char *long_name, const cha
     return &flag->val.as_enum;
 }
 
+uint64_t *argp_flag_enum_set_(const char *short_name, const char *long_name, const char *options[],
+                              size_t option_count, uint64_t def, Argp_Flag_Opt opt) {
+    ARGP_ASSERT(option_count <= 64);
+    Argp_Flag *flag = argp_new_flag(ARGP_ENUM_SET, short_name, long_name, NULL, opt.desc,
+                                    (Argp_Command *)opt.command);
+    argp_flag_opt(flag, opt);
+    flag->val.as_enum_set = def;
+    flag->def.as_enum_set = def;
+    flag->enum_options = options;
+    flag->option_count = option_count;
+    return &flag->val.as_enum_set;
+}
+
 Argp_List *argp_flag_list_(const char *short_name, const char *long_name, Argp_Flag_Opt opt) {
     Argp_Flag *flag = argp_new_flag(ARGP_LIST, short_name, long_name,
                                     opt.meta_var, opt.desc, (Argp_Command *)opt.command);
-    flag->val.as_list = (Argp_List){0};
-    flag->def.as_list = (Argp_List){0};
+    argp_flag_opt(flag, opt);
+    flag->val.as_list = ARGP_ZERO(Argp_List);
+    flag->def.as_list = ARGP_ZERO(Argp_List);
     return &flag->val.as_list;
 }
 
+#ifndef ARGP_MINIMAL
+Argp_Map *argp_flag_map_(const char *short_name, const char *long_name, Argp_Map_Dup dup,
+                         Argp_Flag_Opt opt) {
+    Argp_Flag *flag = argp_new_flag(ARGP_MAP, short_name, long_name,
+                                    opt.meta_var, opt.desc, (Argp_Command *)opt.command);
+    argp_flag_opt(flag, opt);
+    flag->val.as_map = ARGP_ZERO(Argp_Map);
+    flag->def.as_map = ARGP_ZERO(Argp_Map);
+    flag->map_dup = dup;
+    return &flag->val.as_map;
+}
+
+Argp_Ranges *argp_flag_ranges_(const char *short_name, const char *long_name, Argp_Flag_Opt opt) {
+    Argp_Flag *flag = argp_new_flag(ARGP_RANGES, short_name, long_name,
+                                    opt.meta_var, opt.desc, (Argp_Command *)opt.command);
+    argp_flag_opt(flag, opt);
+    flag->val.as_ranges = ARGP_ZERO(Argp_Ranges);
+    flag->def.as_ranges = ARGP_ZERO(Argp_Ranges);
+    return &flag->val.as_ranges;
+}
+
+Argp_Sorted_List *argp_flag_sorted_list_(const char *short_name, const char *long_name, Argp_Flag_Opt opt) {
+    Argp_Flag *flag = argp_new_flag(ARGP_SORTED_LIST, short_name, long_name,
+                                    opt.meta_var, opt.desc, (Argp_Command *)opt.command);
+    argp_flag_opt(flag, opt);
+    flag->val.as_sorted = ARGP_ZERO(Argp_Sorted_List);
+    flag->def.as_sorted = ARGP_ZERO(Argp_Sorted_List);
+    return &flag->val.as_sorted;
+}
+#endif
+
 uint64_t *argp_pos_uint_(const char *name, uint64_t def, Argp_Pos_Opt opt) {
     Argp_Pos *pos = argp_new_pos(ARGP_UINT, name, opt.desc, opt.req,
                                  (Argp_Command *)opt.command);
+    argp_pos_opt(pos, opt);
     pos->val.as_uint = def;
     pos->def.as_uint = def;
     return &pos->val.as_uint;
@@ -422,6 +1341,7 @@ uint64_t *argp_pos_uint_(const char *name, uint64_t def, Argp_Pos_Opt opt) {
 char **argp_pos_str_(const char *name, char *def, Argp_Pos_Opt opt) {
     Argp_Pos *pos = argp_new_pos(ARGP_STR, name, opt.desc, opt.req,
                                  (Argp_Command *)opt.command);
+    argp_pos_opt(pos, opt);
     pos->val.as_str = def;
     pos->def.as_str = def;
     return &pos->val.as_str;
@@ -431,6 +1351,7 @@ size_t *argp_pos_enum_(const char *name, const char *options[], size_t option_co
                        size_t def, Argp_Pos_Opt opt) {
     Argp_Pos *pos = argp_new_pos(ARGP_ENUM, name, opt.desc, opt.req,
                                  (Argp_Command *)opt.command);
+    argp_pos_opt(pos, opt);
     pos->val.as_enum = def;
     pos->def.as_enum = def;
     pos->enum_options = options;
@@ -441,12 +1362,151 @@ size_t *argp_pos_enum_(const char *name, const char *options[], size_t option_co
 Argp_List *argp_pos_list_(const char *name, Argp_Pos_Opt opt) {
     Argp_Pos *pos = argp_new_pos(ARGP_LIST, name, opt.desc, opt.req,
                                  (Argp_Command *)opt.command);
-    pos->val.as_list = (Argp_List){0};
-    pos->def.as_list = (Argp_List){0};
+    argp_pos_opt(pos, opt);
+    pos->val.as_list = ARGP_ZERO(Argp_List);
+    pos->def.as_list = ARGP_ZERO(Argp_List);
     return &pos->val.as_list;
 }
 
-void argp_print_usage(FILE *stream) {
+#ifndef ARGP_MINIMAL
+typedef struct {
+    char *items;
+    size_t size;
+    size_t _cap;
+} Argp_Buf;
+
+// makes room for n more bytes
+static bool argp_buf_reserve(Argp_Buf *buf, size_t n) {
+    if (buf->size + n > buf->_cap) {
+        size_t cap = buf->_cap ? buf->_cap : 256;
+        while (cap < buf->size + n) cap <<= 1;
+
+        char *items = (char *)ARGP_REALLOC(buf->items, cap);
+        if (items == NULL) return false;
+        buf->items = items;
+        buf->_cap = cap;
+    }
+    return true;
+}
+
+static bool argp_buf_append(Argp_Buf *buf, const void *data, size_t n) {
+    if (n == 0) return true;  // data may be NULL then, as the items of an empty list
+    if (!argp_buf_reserve(buf, n)) return false;
+    memcpy(buf->items + buf->size, data, n);
+    buf->size += n;
+    return true;
+}
+
+static bool argp_buf_append_u64(Argp_Buf *buf, uint64_t v) {
+    return argp_buf_append(buf, &v, sizeof(v));
+}
+
+static bool argp_buf_printf(Argp_Buf *buf, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(NULL, 0, fmt, args);
+    va_end(args);
+    if (n < 0) return false;
+
+    // vsnprintf also writes a NUL
+    if (!argp_buf_reserve(buf, (size_t)n + 1)) return false;
+
+    va_start(args, fmt);
+    vsnprintf(buf->items + buf->size, (size_t)n + 1, fmt, args);
+    va_end(args);
+    buf->size += (size_t)n;
+    return true;
+}
+
+Argp_Uint_List *argp_pos_uint_list_(const char *name, Argp_Pos_Opt opt) {
+    Argp_Pos *pos = argp_new_pos(ARGP_UINT_LIST, name, opt.desc, opt.req,
+                                 (Argp_Command *)opt.command);
+    argp_pos_opt(pos, opt);
+    pos->val.as_uint_list = ARGP_ZERO(Argp_Uint_List);
+    pos->def.as_uint_list = ARGP_ZERO(Argp_Uint_List);
+    return &pos->val.as_uint_list;
+}
+
+Argp_Uint_List *argp_pos_enum_list_(const char *name, const char *options[], size_t option_count,
+                                    Argp_Pos_Opt opt) {
+    Argp_Pos *pos = argp_new_pos(ARGP_ENUM_LIST, name, opt.desc, opt.req,
+                                 (Argp_Command *)opt.command);
+    argp_pos_opt(pos, opt);
+    pos->val.as_uint_list = ARGP_ZERO(Argp_Uint_List);
+    pos->def.as_uint_list = ARGP_ZERO(Argp_Uint_List);
+    pos->enum_options = options;
+    pos->option_count = option_count;
+    return &pos->val.as_uint_list;
+}
+
+Argp_Ranges *argp_pos_ranges_(const char *name, Argp_Pos_Opt opt) {
+    Argp_Pos *pos = argp_new_pos(ARGP_RANGES, name, opt.desc, opt.req,
+                                 (Argp_Command *)opt.command);
+    argp_pos_opt(pos, opt);
+    pos->val.as_ranges = ARGP_ZERO(Argp_Ranges);
+    pos->def.as_ranges = ARGP_ZERO(Argp_Ranges);
+    return &pos->val.as_ranges;
+}
+
+Argp_Sorted_List *argp_pos_sorted_list_(const char *name, Argp_Pos_Opt opt) {
+    Argp_Pos *pos = argp_new_pos(ARGP_SORTED_LIST, name, opt.desc, opt.req,
+                                 (Argp_Command *)opt.command);
+    argp_pos_opt(pos, opt);
+    pos->val.as_sorted = ARGP_ZERO(Argp_Sorted_List);
+    pos->def.as_sorted = ARGP_ZERO(Argp_Sorted_List);
+    return &pos->val.as_sorted;
+}
+
+static int argp_print_enum_options(FILE *stream, const char **options, size_t option_count) {
+    int width = fprintf(stream, " {");
+    for (size_t i = 0; i < option_count; ++i) {
+        const char *option = options[i];
+        if (!option) continue;
+        width += fprintf(stream, "%s", option);
+        if (i < option_count - 1)
+            width += fprintf(stream, ",");
+    }
+    return width + fprintf(stream, "}");
+}
+
+static int argp_print_flag_name(FILE *stream, const Argp_Flag *flag) {
+    int width = 0;
+    if (flag->short_name && flag->long_name) {
+        width += fprintf(stream, "-%s, --%s", flag->short_name, flag->long_name);
+    } else if (flag->short_name) {
+        width += fprintf(stream, "-%s", flag->short_name);
+    } else if (flag->long_name) {
+        width += fprintf(stream, "--%s", flag->long_name);
+    } else {
+        ARGP_ASSERT(false && "At least one name of a flag must be non null");
+    }
+
+    if (flag->meta_var)
+        width += fprintf(stream, " %s", flag->meta_var);
+    else if (flag->type == ARGP_ENUM || flag->type == ARGP_ENUM_SET)
+        width += argp_print_enum_options(stream, flag->enum_options, flag->option_count);
+    return width;
+}
+
+static int argp_print_pos_name(FILE *stream, const Argp_Pos *pos) {
+    int width = fprintf(stream, "%s", pos->name);
+    if (pos->type == ARGP_ENUM || pos->type == ARGP_ENUM_LIST)
+        width += argp_print_enum_options(stream, pos->enum_options, pos->option_count);
+    return width;
+}
+
+// ends the line with desc at column ARGP_PRINT_WIDTH, on the next line if width passed it
+static void argp_print_desc(FILE *stream, int width, const char *desc) {
+    if (width >= ARGP_PRINT_WIDTH) {
+        fprintf(stream, "\n");
+        width = 0;
+    }
+    if (!desc) desc = "";
+    int n = ARGP_PRINT_WIDTH - width + (int)strlen(desc);
+    fprintf(stream, "%*s\n", n, desc);
+}
+
+ARGP_COLD void argp_print_usage(FILE *stream) {
     Argp_Ctx *c = &argp_global_ctx;
 
     size_t command_count = c->command_ctx->command_count;
@@ -465,17 +1525,17 @@ void argp_print_usage(FILE *stream) {
 
         if (pos->command != c->command_ctx) continue;
 
-        if (pos->req == ARGP_OPTIONAL) {
-            if (pos->type == ARGP_LIST)
-                fprintf(stream, " [%s...]", pos->name);
-            else
+        size_t min, max;
+        argp_pos_nargs(pos, &min, &max);
+        if (pos->req == ARGP_APPEAR_REQUIRED && min == 0) min = 1;
+
+        for (size_t k = 0; k < min; ++k)
+            fprintf(stream, " %s", pos->name);
+        if (max == SIZE_MAX)
+            fprintf(stream, " [%s...]", pos->name);
+        else
+            for (size_t k = min; k < max; ++k)
                 fprintf(stream, " [%s]", pos->name);
-        } else {
-            if (pos->type == ARGP_LIST)
-                fprintf(stream, " %s [%s...]", pos->name, pos->name);
-            else
-                fprintf(stream, " %s", pos->name);
-        }
     }
     fprintf(stream, "\n\n");
 
@@ -490,16 +1550,8 @@ void argp_print_usage(FILE *stream) {
 
             if (command->parent_command != c->command_ctx) continue;
 
-            int width = 0;
-            width += fprintf(stream, "  %s", command->name);
-
-            if (width >= ARGP_PRINT_WIDTH) {
-                fprintf(stream, "\n");
-                width = 0;
-            }
-
-            int n = ARGP_PRINT_WIDTH - width + (int)strlen(command->desc);
-            fprintf(stream, "%*s\n", n, command->desc);
+            int width = fprintf(stream, "  %s", command->name);
+            argp_print_desc(stream, width, command->desc);
         }
         fprintf(stream, "\n");
     }
@@ -511,28 +1563,9 @@ void argp_print_usage(FILE *stream) {
 
             if (pos->command != c->command_ctx) continue;
 
-            int width = 0;
-            width += fprintf(stream, "  %s", pos->name);
-
-            if (pos->type == ARGP_ENUM) {
-                width += fprintf(stream, " {");
-                for (size_t i = 0; i < pos->option_count; ++i) {
-                    const char *option = pos->enum_options[i];
-                    if (!option) continue;
-                    width += fprintf(stream, "%s", option);
-                    if (i < pos->option_count - 1)
-                        width += fprintf(stream, ",");
-                }
-                width += fprintf(stream, "}");
-            }
-
-            if (width >= ARGP_PRINT_WIDTH) {
-                fprintf(stream, "\n");
-                width = 0;
-            }
-
-            int n = ARGP_PRINT_WIDTH - width + (int)strlen(pos->desc);
-            fprintf(stream, "%*s\n", n, pos->desc);
+            int width = fprintf(stream, "  ");
+            width += argp_print_pos_name(stream, pos);
+            argp_print_desc(stream, width, pos->desc);
         }
         fprintf(stream, "\n");
     }
@@ -544,51 +1577,199 @@ void argp_print_usage(FILE *stream) {
 
             if (flag->command != c->command_ctx) continue;
 
-            int width = 0;
-            if (flag->short_name && flag->long_name) {
-                width += fprintf(stream, "  -%s, --%s", flag->short_name, flag->long_name);
-            } else if (flag->short_name) {
-                width += fprintf(stream, "  -%s", flag->short_name);
-            } else if (flag->long_name) {
-                width += fprintf(stream, "  --%s", flag->long_name);
-            } else {
-                assert(false && "At least one name of a flag must be non null");
-            }
-
-            if (flag->meta_var) {
-                width += fprintf(stream, " %s", flag->meta_var);
-            } else if (flag->type == ARGP_ENUM) {
-                width += fprintf(stream, " {");
-                for (size_t i = 0; i < flag->option_count; ++i) {
-                    const char *option = flag->enum_options[i];
-                    if (!option) continue;
-                    width += fprintf(stream, "%s", option);
-                    if (i < flag->option_count - 1)
-                        width += fprintf(stream, ",");
-                }
-                width += fprintf(stream, "}");
-            }
+            int width = fprintf(stream, "  ");
+            width += argp_print_flag_name(stream, flag);
+            argp_print_desc(stream, width, flag->desc);
+        }
+    }
+}
 
-            if (width >= ARGP_PRINT_WIDTH) {
-                fprintf(stream, "\n");
-                width = 0;
-            }
+enum {
+    ARGP_SEARCH_DESC = 1,
+    ARGP_SEARCH_COMMAND_PATH = 2,
+    ARGP_SEARCH_OPTION = 4,
+    ARGP_SEARCH_NAME = 8,
+};
 
-            int n = ARGP_PRINT_WIDTH - width + (int)strlen(flag->desc);
-            fprintf(stream, "%*s\n", n, flag->desc);
+// adds the words of s, lowercased and split at anything but letters and digits
+// names are added whole as well, so --dry-run matches dry-run
+static bool argp_search_add(Argp_Search_Index *index, size_t entry, int weight, const char *s) {
+    if (!s) return true;
+
+    for (size_t i = 0;;) {
+        while (s[i] && !isalnum((unsigned char)s[i]) && weight != ARGP_SEARCH_NAME) ++i;
+        if (!s[i]) return true;
+
+        size_t start = i;
+        while (s[i] && (isalnum((unsigned char)s[i]) || weight == ARGP_SEARCH_NAME)) ++i;
+        size_t n = i - start;
+
+        if (index->word_count == index->word_cap) {
+            size_t cap = index->word_cap ? index->word_cap << 1 : 64;
+            Argp_Search_Word *words = (Argp_Search_Word *)ARGP_REALLOC(index->words, cap * sizeof(Argp_Search_Word));
+            if (words == NULL) return false;
+            index->words = words;
+            index->word_cap = cap;
         }
+        Argp_Buf buf = {index->text, index->text_size, index->text_cap};
+        if (!argp_buf_reserve(&buf, n + 1)) return false;
+        index->text = buf.items;
+        index->text_cap = buf._cap;
+
+        Argp_Search_Word *w = index->words + index->word_count++;
+        w->text = index->text_size;
+        w->entry = entry;
+        w->weight = weight;
+        for (size_t k = 0; k < n; ++k)
+            index->text[index->text_size++] = (char)tolower((unsigned char)s[start + k]);
+        index->text[index->text_size++] = '\0';
+    }
+}
+
+static bool argp_search_add_path(Argp_Search_Index *index, size_t entry, const Argp_Command *command) {
+    Argp_Ctx *c = &argp_global_ctx;
+    for (; command && command != c->program_command; command = command->parent_command) {
+        if (!argp_search_add(index, entry, ARGP_SEARCH_COMMAND_PATH, command->name)) return false;
+    }
+    return true;
+}
+
+static bool argp_search_add_options(Argp_Search_Index *index, size_t entry, const char **options, size_t option_count) {
+    for (size_t i = 0; i < option_count; ++i) {
+        if (!argp_search_add(index, entry, ARGP_SEARCH_OPTION, options[i])) return false;
+    }
+    return true;
+}
+
+static bool argp_search_build(Argp_Search_Index *index) {
+    Argp_Ctx *c = &argp_global_ctx;
+    size_t entry_count = c->command_capacity + c->flag_capacity + c->pos_capacity;
+    if (index->entry_count == entry_count) return true;
+
+    index->text_size = 0;
+    index->word_count = 0;
+    index->entry_count = 0;
+    bool ok = true;
+    size_t entry = 0;
+
+    for (size_t i = 0; ok && i < c->command_capacity; ++i, ++entry) {
+        const Argp_Command *command = c->commands + i;
+        if (command == c->program_command) continue;
+        ok = argp_search_add(index, entry, ARGP_SEARCH_NAME, command->name) &&
+             argp_search_add(index, entry, ARGP_SEARCH_DESC, command->desc) &&
+             argp_search_add_path(index, entry, command->parent_command);
+    }
+    for (size_t i = 0; ok && i < c->flag_capacity; ++i, ++entry) {
+        const Argp_Flag *flag = c->flags + i;
+        if (flag == flag->command->help_flag || flag == c->help_search_flag) continue;
+        ok = argp_search_add(index, entry, ARGP_SEARCH_NAME, flag->short_name) &&
+             argp_search_add(index, entry, ARGP_SEARCH_NAME, flag->long_name) &&
+             argp_search_add(index, entry, ARGP_SEARCH_DESC, flag->desc) &&
+             argp_search_add(index, entry, ARGP_SEARCH_DESC, flag->meta_var) &&
+             argp_search_add_options(index, entry, flag->enum_options, flag->option_count) &&
+             argp_search_add_path(index, entry, flag->command);
+    }
+    for (size_t i = 0; ok && i < c->pos_capacity; ++i, ++entry) {
+        const Argp_Pos *pos = c->poss + i;
+        ok = argp_search_add(index, entry, ARGP_SEARCH_NAME, pos->name) &&
+             argp_search_add(index, entry, ARGP_SEARCH_DESC, pos->desc) &&
+             argp_search_add_options(index, entry, pos->enum_options, pos->option_count) &&
+             argp_search_add_path(index, entry, pos->command);
     }
+
+    if (ok) index->entry_count = entry_count;
+    return ok;
+}
+
+typedef struct {
+    int score;
+    size_t entry;
+} Argp_Search_Hit;
+
+static int argp_search_hit_cmp(const void *a, const void *b) {
+    const Argp_Search_Hit *x = (const Argp_Search_Hit *)a, *y = (const Argp_Search_Hit *)b;
+    if (x->score != y->score) return x->score > y->score ? -1 : 1;
+    return x->entry < y->entry ? -1 : x->entry > y->entry;
+}
+
+static void argp_search_print(FILE *stream, size_t entry) {
+    Argp_Ctx *c = &argp_global_ctx;
+    int width = fprintf(stream, " ");
+
+    if (entry < c->command_capacity) {
+        const Argp_Command *command = c->commands + entry;
+        width += print_full_command_name(stream, command);
+        argp_print_desc(stream, width, command->desc);
+        return;
+    }
+
+    entry -= c->command_capacity;
+    if (entry < c->flag_capacity) {
+        const Argp_Flag *flag = c->flags + entry;
+        width += print_full_command_name(stream, flag->command);
+        width += fprintf(stream, " ");
+        width += argp_print_flag_name(stream, flag);
+        argp_print_desc(stream, width, flag->desc);
+        return;
+    }
+
+    const Argp_Pos *pos = c->poss + (entry - c->flag_capacity);
+    width += print_full_command_name(stream, pos->command);
+    width += fprintf(stream, " ");
+    width += argp_print_pos_name(stream, pos);
+    argp_print_desc(stream, width, pos->desc);
 }
 
-void argp_print_error(FILE *stream) {
+ARGP_COLD size_t argp_help_search(FILE *stream, const char *term) {
     Argp_Ctx *c = &argp_global_ctx;
-    switch (c->err) {
+    Argp_Search_Index *index = &c->search;
+
+    // -v and --verbose search for the name
+    while (*term == '-') ++term;
+    char query[256];
+    size_t n = 0;
+    for (; term[n] && n < sizeof(query) - 1; ++n) query[n] = (char)tolower((unsigned char)term[n]);
+    query[n] = '\0';
+
+    Argp_Search_Hit *hits = NULL;
+    if (n == 0 || !argp_search_build(index) ||
+        !(hits = (Argp_Search_Hit *)ARGP_REALLOC(NULL, index->entry_count * sizeof(Argp_Search_Hit)))) {
+        fprintf(stream, "no arguments match '%s'\n", term);
+        return 0;
+    }
+    for (size_t i = 0; i < index->entry_count; ++i) {
+        hits[i].score = 0;
+        hits[i].entry = i;
+    }
+
+    // 3 for the whole word, 2 for a prefix, 1 for a substring, times the weight of the field
+    for (size_t i = 0; i < index->word_count; ++i) {
+        const Argp_Search_Word *word = index->words + i;
+        const char *text = index->text + word->text;
+        const char *at = strstr(text, query);
+        if (!at) continue;
+
+        int score = (at != text ? 1 : text[n] ? 2 : 3) * word->weight;
+        if (score > hits[word->entry].score) hits[word->entry].score = score;
+    }
+
+    qsort(hits, index->entry_count, sizeof(Argp_Search_Hit), argp_search_hit_cmp);
+    size_t count = 0;
+    while (count < index->entry_count && hits[count].score) argp_search_print(stream, hits[count++].entry);
+    if (count == 0) fprintf(stream, "no arguments match '%s'\n", term);
+
+    ARGP_FREE(hits);
+    return count;
+}
+
+static void argp_print_record(FILE *stream, const Argp_Error_Record *r) {
+    switch (r->code) {
         case ARGP_NO_ERROR: {
             fprintf(stream, "No errors parsing arguments\n");
             return;
         } break;
         case ARGP_ERROR_UNKNOWN: {
-            fprintf(stream, "Error: Unknown option %s\n", c->unknown_option);
+            fprintf(stream, "Error: Unknown option %s\n", r->token);
             return;
         } break;
         case ARGP_ERROR_UNKNOWN_ENUM: {
@@ -606,41 +1787,75 @@ void argp_print_error(FILE *stream) {
         case ARGP_ERROR_ALLOC: {
             fprintf(stream, "Error: Allocating");
         } break;
+        case ARGP_ERROR_INVALID_ENTRY: {
+            fprintf(stream, "Error: Expected key=value");
+        } break;
+        case ARGP_ERROR_DUPLICATE_KEY: {
+            fprintf(stream, "Error: Duplicate key");
+        } break;
+        case ARGP_ERROR_PATH_NOT_FOUND: {
+            fprintf(stream, "Error: No such file or directory");
+        } break;
+        case ARGP_ERROR_PATH_NOT_FILE: {
+            fprintf(stream, "Error: Not a regular file");
+        } break;
+        case ARGP_ERROR_PATH_NOT_DIR: {
+            fprintf(stream, "Error: Not a directory");
+        } break;
+        case ARGP_ERROR_PATH_NOT_READABLE: {
+            fprintf(stream, "Error: Permission denied");
+        } break;
+        case ARGP_ERROR_PATH_LOOP: {
+            fprintf(stream, "Error: Too many levels of symbolic links");
+        } break;
+        case ARGP_ERROR_PATH_TOO_LONG: {
+            fprintf(stream, "Error: File name too long");
+        } break;
+        case ARGP_ERROR_PATH_IO: {
+            fprintf(stream, "Error: Could not access path");
+        } break;
+        case ARGP_ERROR_INVALID_RANGE: {
+            fprintf(stream, "Error: Range start is greater than its end");
+        } break;
+        case ARGP_ERROR_RANGE_OVERLAP: {
+            fprintf(stream, "Error: Overlapping range");
+        } break;
+        case ARGP_ERROR_SNAPSHOT: {
+            fprintf(stream, "Error: Invalid or incompatible snapshot\n");
+            return;
+        } break;
         case ARGP_ERROR_COUNT:
             ARGP_ASSERT(false && "Unreachable");
     }
 
-    Argp_Type type;
-    const char **enum_option;
-    size_t option_count;
-    if (c->err_flag) {
-        const Argp_Flag *flag = c->err_flag;
-        if (flag->long_name)
-            fprintf(stream, " for flag --%s", flag->long_name);
-        else
-            fprintf(stream, " for flag -%s", flag->short_name);
+    // not tied to an argument, e.g. a config file that can't be read
+    if (!r->short_name && !r->long_name && !r->pos_name) {
+        if (r->token) fprintf(stream, " '%s'", r->token);
+        fprintf(stream, "\n");
+        return;
+    }
 
-        type = c->err_flag->type;
-        enum_option = c->err_flag->enum_options;
-        option_count = c->err_flag->option_count;
-    } else {
-        fprintf(stream, " for positional argument %s", c->err_pos->name);
+    if (r->long_name)
+        fprintf(stream, " for flag --%s", r->long_name);
+    else if (r->short_name)
+        fprintf(stream, " for flag -%s", r->short_name);
+    else
+        fprintf(stream, " for positional argument %s", r->pos_name);
 
-        type = c->err_pos->type;
-        enum_option = c->err_pos->enum_options;
-        option_count = c->err_pos->option_count;
-    }
+    if (r->token)
+        fprintf(stream, " got '%s'", r->token);
 
-    if (c->unknown_option)
-        fprintf(stream, " got '%s'", c->unknown_option);
+    if (r->index != SIZE_MAX)
+        fprintf(stream, " at index %zu", r->index);
 
-    if (type == ARGP_ENUM) {
+    if (r->options) {
         fprintf(stream, " expected {");
-        for (size_t i = 0; i < option_count; ++i) {
-            const char *option = enum_option[i];
+        for (size_t i = 0; i < r->option_count; ++i) {
+            const char *option = r->options[i];
+            if (!option) continue;
             fprintf(stream, "%s", option);
 
-            if (i < option_count - 1)
+            if (i < r->option_count - 1)
                 fprintf(stream, ",");
         }
         fprintf(stream, "}");
@@ -649,37 +1864,159 @@ void argp_print_error(FILE *stream) {
     fprintf(stream, "\n");
 }
 
-static Argp_Flag *try_short_name(const char *arg, size_t n) {
+ARGP_COLD void argp_print_error(FILE *stream) {
     Argp_Ctx *c = &argp_global_ctx;
-    if (n < 1) return NULL;
-    if (arg[0] != '-') return NULL;
-    const char *short_name = arg + 1;
+    Argp_Error_Record r = argp_error_record();
+    if (c->error_total == 0) {
+        argp_print_record(stream, &r);
+        return;
+    }
+
+    for (size_t i = 0; i < c->error_count; ++i)
+        argp_print_record(stream, c->errors + i);
+    if (c->error_total > c->error_count)
+        fprintf(stream, "Error: %zu more errors\n", c->error_total - c->error_count);
+    // the error that stopped the parse
+    if (c->err == ARGP_ERROR_ALLOC)
+        argp_print_record(stream, &r);
+}
+#endif  // ARGP_MINIMAL
+
+static Argp_Name *argp_name_slot(unsigned kind, const void *scope, const char *name, size_t n) {
+    Argp_Ctx *c = &argp_global_ctx;
+    uint64_t h = c->seed ^ argp_hash_mix((uint64_t)(uintptr_t)scope ^ kind);
+    size_t mask = c->names.cap - 1;
+    size_t i = (size_t)argp_hash_mix(argp_hash_bytes(h, name, n)) & mask;
+
+    for (;; i = (i + 1) & mask) {
+        ARGP_PROBE();
+        Argp_Name *entry = c->names.items + i;
+        if (!entry->name) return entry;
+        if (entry->kind == kind && entry->scope == scope && strncmp(entry->name, name, n) == 0 &&
+            entry->name[n] == '\0')
+            return entry;
+    }
+}
+
+// index of the first n bytes of name, which need not be NUL terminated, SIZE_MAX if absent
+static size_t argp_name_find(unsigned kind, const void *scope, const char *name, size_t n) {
+    if (argp_global_ctx.names.cap == 0) return SIZE_MAX;
+    const Argp_Name *entry = argp_name_slot(kind, scope, name, n);
+    return entry->name ? entry->index : SIZE_MAX;
+}
+
+static void argp_name_add(unsigned kind, const void *scope, const char *name, size_t index) {
+    if (!name) return;
+    Argp_Name *entry = argp_name_slot(kind, scope, name, strlen(name));
+    // the first of equal names wins, as it did when they were scanned
+    if (entry->name) return;
+    entry->name = name;
+    entry->scope = scope;
+    entry->kind = kind;
+    entry->index = index;
+}
+
+static size_t argp_enum_option_count(Argp_Type type, size_t option_count) {
+    return type == ARGP_ENUM || type == ARGP_ENUM_SET || type == ARGP_ENUM_LIST ? option_count : 0;
+}
+
+static bool argp_names_build(void) {
+    Argp_Ctx *c = &argp_global_ctx;
+    Argp_Names *names = &c->names;
+    size_t entry_count = c->command_capacity + c->flag_capacity + c->pos_capacity;
+    if (names->cap && names->entry_count == entry_count) return true;
+
+    size_t n = c->command_capacity + 2 * c->flag_capacity;
+    for (size_t i = 0; i < c->flag_capacity; ++i)
+        n += argp_enum_option_count(c->flags[i].type, c->flags[i].option_count);
+    for (size_t i = 0; i < c->pos_capacity; ++i)
+        n += argp_enum_option_count(c->poss[i].type, c->poss[i].option_count);
+
+    size_t cap = 16;
+    while (cap < 2 * n) cap <<= 1;
+    Argp_Name *items = cap <= SIZE_MAX / sizeof(Argp_Name)
+                           ? (Argp_Name *)ARGP_REALLOC(names->items, cap * sizeof(Argp_Name))
+                           : NULL;
+    if (items == NULL) {
+        c->err = ARGP_ERROR_ALLOC;
+        return false;
+    }
+    memset(items, 0, cap * sizeof(Argp_Name));
+    names->items = items;
+    names->cap = cap;
+    names->entry_count = entry_count;
 
+    for (size_t i = 0; i < c->command_capacity; ++i)
+        argp_name_add(ARGP_NAME_COMMAND, c->commands[i].parent_command, c->commands[i].name, i);
     for (size_t i = 0; i < c->flag_capacity; ++i) {
-        Argp_Flag *flag = c->flags + i;
-        if (flag->command != c->command_ctx || !flag->short_name) continue;
-        if (strcmp(short_name, flag->short_name) == 0)
-            return flag;
+        const Argp_Flag *flag = c->flags + i;
+        argp_name_add(ARGP_NAME_SHORT, flag->command, flag->short_name, i);
+        argp_name_add(ARGP_NAME_LONG, flag->command, flag->long_name, i);
+        for (size_t k = 0; k < argp_enum_option_count(flag->type, flag->option_count); ++k)
+            argp_name_add(ARGP_NAME_OPTION, flag, flag->enum_options[k], k);
     }
+    for (size_t i = 0; i < c->pos_capacity; ++i) {
+        const Argp_Pos *pos = c->poss + i;
+        for (size_t k = 0; k < argp_enum_option_count(pos->type, pos->option_count); ++k)
+            argp_name_add(ARGP_NAME_OPTION, pos, pos->enum_options[k], k);
+    }
+    return true;
+}
 
-    return NULL;
+static Argp_Flag *try_short_name(const char *arg, size_t n) {
+    Argp_Ctx *c = &argp_global_ctx;
+    if (n < 1) return NULL;
+    if (arg[0] != '-') return NULL;
+
+    size_t i = argp_name_find(ARGP_NAME_SHORT, c->command_ctx, arg + 1, n - 1);
+    return i == SIZE_MAX ? NULL : c->flags + i;
 }
 
-static Argp_Flag *try_long_name(const char *arg, size_t n) {
+static Argp_Flag *try_long_name(char *arg, size_t n) {
     Argp_Ctx *c = &argp_global_ctx;
     if (n < 2) return NULL;
     if (arg[0] != '-' || arg[1] != '-')
         return NULL;
-    const char *long_name = arg + 2;
+    char *long_name = arg + 2;
+    char *eq = strchr(long_name, '=');
+    size_t len = eq ? (size_t)(eq - long_name) : n - 2;
 
-    for (size_t i = 0; i < c->flag_capacity; ++i) {
-        Argp_Flag *flag = c->flags + i;
-        if (flag->command != c->command_ctx || flag->long_name) continue;
-        if (strcmp(long_name, flag->long_name) == 0)
-            return flag;
-    }
+    size_t i = argp_name_find(ARGP_NAME_LONG, c->command_ctx, long_name, len);
+    if (i == SIZE_MAX) return NULL;
+    Argp_Flag *flag = c->flags + i;
 
-    return NULL;
+    // bool flags take no value
+    if (eq && flag->type == ARGP_BOOL) return NULL;
+    c->inline_value = eq ? eq + 1 : NULL;
+    return flag;
+}
+
+// parses exactly n decimal digits, no sign or whitespace
+static Argp_Error argp_parse_digits(const char *s, size_t n, uint64_t *v) {
+    if (n == 0) return ARGP_ERROR_INVALID_NUMBER;
+
+#ifdef ARGP_HAVE_FROM_CHARS
+    // from_chars also stops at the first non-digit after an overflow, so the errors match
+    uint64_t result;
+    std::from_chars_result r = std::from_chars(s, s + n, result);
+    if (r.ptr != s + n || r.ec == std::errc::invalid_argument) return ARGP_ERROR_INVALID_NUMBER;
+    if (r.ec == std::errc::result_out_of_range) return ARGP_ERROR_INTEGER_OVERFLOW;
+#else
+    uint64_t result = 0;
+    for (size_t i = 0; i < n; ++i) {
+        unsigned d = (unsigned)(s[i] - '0');
+        if (d > 9) return ARGP_ERROR_INVALID_NUMBER;
+        if (result > (UINT64_MAX - d) / 10) {
+            // keep scanning so "99999999999999999999x" is reported as invalid
+            for (++i; i < n; ++i)
+                if ((unsigned)(s[i] - '0') > 9) return ARGP_ERROR_INVALID_NUMBER;
+            return ARGP_ERROR_INTEGER_OVERFLOW;
+        }
+        result = result * 10 + d;
+    }
+#endif
+    *v = result;
+    return ARGP_NO_ERROR;
 }
 
 static bool argp_parse_uint(char *arg, uint64_t *v) {
@@ -689,20 +2026,13 @@ static bool argp_parse_uint(char *arg, uint64_t *v) {
         c->err = ARGP_ERROR_NO_VALUE;
         return false;
     }
-    char *endptr;
-    uint64_t result = strtoull(arg, &endptr, 10);
 
-    if (*endptr != 0) {
-        c->err = ARGP_ERROR_INVALID_NUMBER;
-        c->unknown_option = arg;
-        return false;
-    }
-    if (result == ULLONG_MAX && errno == ERANGE) {
-        c->err = ARGP_ERROR_INTEGER_OVERFLOW;
+    Argp_Error err = argp_parse_digits(arg, strlen(arg), v);
+    if (err != ARGP_NO_ERROR) {
+        c->err = err;
         c->unknown_option = arg;
         return false;
     }
-    *v = result;
     return true;
 }
 
@@ -717,7 +2047,16 @@ static bool argp_parse_str(char *arg, char **v) {
     return true;
 }
 
-static bool argp_parse_enum(char *arg, size_t *v, const char **enum_options, size_t option_count) {
+// looks up the first n bytes of arg among the options of the flag or positional owner,
+// arg does not need to be NUL terminated
+static bool argp_find_enum(const void *owner, const char *arg, size_t n, size_t *v) {
+    size_t i = argp_name_find(ARGP_NAME_OPTION, owner, arg, n);
+    if (i == SIZE_MAX) return false;
+    *v = i;
+    return true;
+}
+
+static bool argp_parse_enum(const void *owner, char *arg, size_t *v) {
     Argp_Ctx *c = &argp_global_ctx;
 
     if (!arg) {
@@ -725,59 +2064,508 @@ static bool argp_parse_enum(char *arg, size_t *v, const char **enum_options, siz
         return false;
     }
 
-    for (size_t i = 0; i < option_count; ++i) {
-        const char *option = enum_options[i];
-        if (!option) continue;
-        if (strcmp(arg, option) == 0) {
-            *v = i;
-            return true;
-        }
-    }
+    if (argp_find_enum(owner, arg, strlen(arg), v))
+        return true;
 
     c->err = ARGP_ERROR_UNKNOWN_ENUM;
     c->unknown_option = arg;
     return false;
 }
 
+static bool argp_parse_enum_set(const void *owner, char *arg, uint64_t *v) {
+    Argp_Ctx *c = &argp_global_ctx;
+
+    if (!arg) {
+        c->err = ARGP_ERROR_NO_VALUE;
+        return false;
+    }
+
+    uint64_t set = 0;
+    const char *begin = arg;
+    for (;;) {
+        const char *end = strchr(begin, ',');
+        size_t n = end ? (size_t)(end - begin) : strlen(begin);
+
+        size_t i;
+        if (!argp_find_enum(owner, begin, n, &i)) {
+            c->err = ARGP_ERROR_UNKNOWN_ENUM;
+            c->unknown_option = arg;
+            return false;
+        }
+        set |= (uint64_t)1 << i;
+
+        if (!end) break;
+        begin = end + 1;
+    }
+
+    *v |= set;
+    return true;
+}
+
 static bool argp_parse_list_entry(char *arg, Argp_List *list) {
+    Argp_Ctx *c = &argp_global_ctx;
+
+    if (!arg) {
+        c->err = ARGP_ERROR_NO_VALUE;
+        return false;
+    }
+
     if (list->_cap == 0 || list->size == list->_cap) {
-        list->_cap = list->_cap ? list->_cap << 1 : ARGP_LIST_INIT_CAP;
+        size_t cap = list->_cap ? list->_cap << 1 : ARGP_LIST_INIT_CAP;
 
-        char **temp = list->items;
-        list->items = (char **)ARGP_REALLOC(NULL, list->_cap * sizeof(char *));
-        if (list->items == NULL) {
-            ARGP_FREE(temp);
+        char **items = cap <= SIZE_MAX / sizeof(char *)
+                           ? (char **)ARGP_REALLOC(list->items, cap * sizeof(char *))
+                           : NULL;
+        if (items == NULL) {
+            c->err = ARGP_ERROR_ALLOC;
             return false;
         }
+        list->items = items;
+        list->_cap = cap;
     }
 
     list->items[list->size++] = arg;
     return true;
 }
 
-static bool argp_parse_flag(Argp_Flag *flag) {
+#ifndef ARGP_MINIMAL
+// the error for a path that could not be opened, checked or read
+static Argp_Error argp_path_error(int err) {
+    switch (err) {
+        case ENOENT: return ARGP_ERROR_PATH_NOT_FOUND;
+        case ENOTDIR: return ARGP_ERROR_PATH_NOT_DIR;
+        case EISDIR: return ARGP_ERROR_PATH_NOT_FILE;
+        case EACCES:
+        case EPERM: return ARGP_ERROR_PATH_NOT_READABLE;
+        case ELOOP: return ARGP_ERROR_PATH_LOOP;
+        case ENAMETOOLONG: return ARGP_ERROR_PATH_TOO_LONG;
+        default: return ARGP_ERROR_PATH_IO;
+    }
+}
+
+// adds an entry of a sorted list, @file and @- add one entry per non-empty line
+// the lines are split in place in a buffer kept until the lists are encoded
+static bool argp_parse_sorted_entry(char *arg, Argp_List *pending) {
     Argp_Ctx *c = &argp_global_ctx;
-    switch (flag->type) {
-        case ARGP_BOOL: {
-            flag->val.as_bool = true;
-        } break;
-        case ARGP_UINT: {
-            char *arg = shift_args();
-            if (!argp_parse_uint(arg, &flag->val.as_uint)) {
-                c->err_flag = flag;
-                return false;
-            }
-        } break;
-        case ARGP_STR: {
-            char *arg = shift_args();
-            if (!argp_parse_str(arg, &flag->val.as_str)) {
+
+    if (!arg || arg[0] != '@') return argp_parse_list_entry(arg, pending);
+    if (arg[1] == '@') return argp_parse_list_entry(arg + 1, pending);
+
+    const char *path = arg + 1;
+    int fd = STDIN_FILENO;
+    if (strcmp(path, "-") != 0) {
+        int flags = O_RDONLY;
+#ifdef O_CLOEXEC
+        flags |= O_CLOEXEC;
+#endif
+        fd = open(path, flags);
+        if (fd < 0) {
+            c->err = argp_path_error(errno);
+            c->unknown_option = path;
+            return false;
+        }
+    }
+
+    Argp_Buf buf = ARGP_ZERO(Argp_Buf);
+    bool ok = true;
+    for (;;) {
+        // keep a byte for the terminating NUL
+        if (!argp_buf_reserve(&buf, 1 << 16)) {
+            c->err = ARGP_ERROR_ALLOC;
+            ok = false;
+            break;
+        }
+        ssize_t n = read(fd, buf.items + buf.size, buf._cap - buf.size - 1);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            c->err = argp_path_error(errno);
+            c->unknown_option = path;
+            ok = false;
+        }
+        if (n <= 0) break;
+        buf.size += (size_t)n;
+    }
+    if (fd != STDIN_FILENO) close(fd);
+
+    if (!ok || !argp_parse_list_entry(buf.items, &c->ingested)) {
+        ARGP_FREE(buf.items);
+        return false;
+    }
+    buf.items[buf.size] = '\0';
+
+    for (char *p = buf.items; *p;) {
+        char *end = strchr(p, '\n');
+        char *next = end ? end + 1 : p + strlen(p);
+        size_t n = end ? (size_t)(end - p) : (size_t)(next - p);
+        if (n && p[n - 1] == '\r') --n;
+        p[n] = '\0';
+        if (n && !argp_parse_list_entry(p, pending)) return false;
+        p = next;
+    }
+    return true;
+}
+
+static void argp_free_ingested(void) {
+    Argp_Ctx *c = &argp_global_ctx;
+    for (size_t i = 0; i < c->ingested.size; ++i) ARGP_FREE(c->ingested.items[i]);
+    c->ingested.size = 0;
+}
+
+static bool argp_buf_append_varint(Argp_Buf *buf, size_t v) {
+    unsigned char bytes[(sizeof(size_t) * 8 + 6) / 7];
+    size_t n = 0;
+    do {
+        bytes[n++] = (unsigned char)((v & 0x7f) | (v > 0x7f ? 0x80 : 0));
+        v >>= 7;
+    } while (v);
+    return argp_buf_append(buf, bytes, n);
+}
+
+static size_t argp_read_varint(const char **p) {
+    size_t v = 0;
+    for (unsigned shift = 0;; shift += 7) {
+        unsigned char b = (unsigned char)*(*p)++;
+        v |= (size_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return v;
+    }
+}
+
+// front-codes n sorted entries, equal neighbours are stored once
+static bool argp_sorted_encode(char *const *items, size_t n, Argp_Sorted_List *out) {
+    size_t max_blocks = (n + ARGP_SORTED_BLOCK - 1) / ARGP_SORTED_BLOCK;
+    size_t *offsets = n ? (size_t *)ARGP_REALLOC(NULL, max_blocks * sizeof(size_t)) : NULL;
+    if (n && offsets == NULL) return false;
+
+    Argp_Sorted_List list = ARGP_ZERO(Argp_Sorted_List);
+    Argp_Buf buf = ARGP_ZERO(Argp_Buf);
+    const char *prev = NULL;
+    bool ok = true;
+    for (size_t i = 0; ok && i < n; ++i) {
+        const char *s = items[i];
+        if (prev && strcmp(prev, s) == 0) continue;
+
+        size_t len = strlen(s), shared = 0;
+        if (list.count % ARGP_SORTED_BLOCK == 0) {
+            offsets[list.count / ARGP_SORTED_BLOCK] = buf.size;
+        } else {
+            while (prev[shared] && prev[shared] == s[shared]) ++shared;
+            ok = argp_buf_append_varint(&buf, shared);
+        }
+        ok = ok && argp_buf_append(&buf, s + shared, len - shared + 1);
+
+        if (len > list.max_len) list.max_len = len;
+        ++list.count;
+        prev = s;
+    }
+
+    // one allocation holding the offsets of the blocks that were used, then the blocks
+    size_t table = argp_sorted_block_count(&list) * sizeof(size_t);
+    if (ok && list.count) {
+        list._data = (char *)ARGP_REALLOC(NULL, table + buf.size);
+        ok = list._data != NULL;
+    }
+    if (ok && list.count) {
+        memcpy(list._data, offsets, table);
+        memcpy(list._data + table, buf.items, buf.size);
+    }
+    ARGP_FREE(offsets);
+    ARGP_FREE(buf.items);
+    if (!ok) return false;
+
+    *out = list;
+    return true;
+}
+
+static int argp_str_cmp(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// sorts and encodes the collected entries, the pending list is released either way
+static bool argp_sort_list(Argp_List *pending, Argp_Sorted_List *val) {
+    qsort(pending->items, pending->size, sizeof(char *), argp_str_cmp);
+    bool ok = argp_sorted_encode(pending->items, pending->size, val);
+    argp_free_list(pending);
+    *pending = ARGP_ZERO(Argp_List);
+    if (!ok) argp_global_ctx.err = ARGP_ERROR_ALLOC;
+    return ok;
+}
+
+typedef enum {
+    ARGP_MAP_INSERTED,
+    ARGP_MAP_REPLACED,
+    ARGP_MAP_DUPLICATE,
+    ARGP_MAP_NO_MEMORY,
+} Argp_Map_Insert;
+
+static Argp_Map_Entry *argp_map_slot(Argp_Map_Entry *items, size_t cap, const char *key) {
+    size_t mask = cap - 1;
+    size_t i = (size_t)argp_hash_mix(argp_hash_str(argp_global_ctx.seed, key)) & mask;
+    for (;; i = (i + 1) & mask) {
+        ARGP_PROBE();
+        if (!items[i].key || strcmp(items[i].key, key) == 0) return items + i;
+    }
+}
+
+static Argp_Map_Insert argp_map_insert(Argp_Map *map, char *key, char *value, bool replace) {
+    // capacity is a power of two and the load factor stays at or below one half
+    if ((map->size + 1) * 2 > map->_cap) {
+        size_t cap = map->_cap ? map->_cap << 1 : 16;
+
+        Argp_Map_Entry *items = (Argp_Map_Entry *)ARGP_REALLOC(NULL, cap * sizeof(Argp_Map_Entry));
+        if (items == NULL) return ARGP_MAP_NO_MEMORY;
+        memset(items, 0, cap * sizeof(Argp_Map_Entry));
+
+        for (size_t i = 0; i < map->_cap; ++i) {
+            if (map->items[i].key)
+                *argp_map_slot(items, cap, map->items[i].key) = map->items[i];
+        }
+
+        ARGP_FREE(map->items);
+        map->items = items;
+        map->_cap = cap;
+    }
+
+    Argp_Map_Entry *entry = argp_map_slot(map->items, map->_cap, key);
+    if (entry->key) {
+        if (!replace) return ARGP_MAP_DUPLICATE;
+        entry->value = value;
+        return ARGP_MAP_REPLACED;
+    }
+
+    entry->key = key;
+    entry->value = value;
+    ++map->size;
+    return ARGP_MAP_INSERTED;
+}
+
+static bool argp_parse_map_entry(char *arg, Argp_Map *map, Argp_Map_Dup dup) {
+    Argp_Ctx *c = &argp_global_ctx;
+
+    if (!arg) {
+        c->err = ARGP_ERROR_NO_VALUE;
+        return false;
+    }
+
+    char *sep = strchr(arg, '=');
+    if (!sep || sep == arg) {
+        c->err = ARGP_ERROR_INVALID_ENTRY;
+        c->unknown_option = arg;
+        return false;
+    }
+    *sep = '\0';
+
+    switch (argp_map_insert(map, arg, sep + 1, dup == ARGP_MAP_LAST_WINS)) {
+        case ARGP_MAP_INSERTED:
+        case ARGP_MAP_REPLACED:
+            return true;
+        case ARGP_MAP_DUPLICATE: {
+            c->err = ARGP_ERROR_DUPLICATE_KEY;
+            c->unknown_option = arg;
+        } break;
+        case ARGP_MAP_NO_MEMORY: {
+            c->err = ARGP_ERROR_ALLOC;
+        } break;
+    }
+    return false;
+}
+
+static bool argp_uint_list_push(Argp_Uint_List *list, uint64_t v) {
+    if (list->size == list->_cap) {
+        size_t cap = list->_cap ? list->_cap << 1 : ARGP_LIST_INIT_CAP;
+
+        uint64_t *items = cap <= SIZE_MAX / sizeof(uint64_t)
+                              ? (uint64_t *)ARGP_REALLOC(list->items, cap * sizeof(uint64_t))
+                              : NULL;
+        if (items == NULL) {
+            argp_global_ctx.err = ARGP_ERROR_ALLOC;
+            return false;
+        }
+        list->items = items;
+        list->_cap = cap;
+    }
+
+    list->items[list->size++] = v;
+    return true;
+}
+
+// converts one entry of a uint or enum list, shared by the serial and parallel paths
+static Argp_Error argp_convert_entry(const Argp_Pos *pos, const char *arg, uint64_t *v) {
+    size_t n = strlen(arg);
+    if (pos->type == ARGP_UINT_LIST) return argp_parse_digits(arg, n, v);
+
+    size_t i;
+    if (!argp_find_enum(pos, arg, n, &i))
+        return ARGP_ERROR_UNKNOWN_ENUM;
+    *v = i;
+    return ARGP_NO_ERROR;
+}
+
+// merges n entries sorted by lo into the set in one pass
+// an entry overlapping another is reported if it was read later, ranges already in the set come first
+static bool argp_ranges_merge(Argp_Ranges *ranges, const Argp_Range_Entry *entries, size_t n) {
+    Argp_Ctx *c = &argp_global_ctx;
+    size_t cap = ranges->size + n;
+    Argp_Range *out = (Argp_Range *)ARGP_REALLOC(NULL, cap * sizeof(Argp_Range));
+    if (out == NULL) {
+        c->err = ARGP_ERROR_ALLOC;
+        return false;
+    }
+
+    size_t size = 0, i = 0, j = 0;
+    const Argp_Range_Entry *last = NULL;  // entry that produced out[size - 1], NULL for the set
+    const Argp_Range_Entry *reported = NULL;
+    while (i < ranges->size || j < n) {
+        bool take_entry = j < n && (i == ranges->size || entries[j].r.lo < ranges->items[i].lo);
+        const Argp_Range_Entry *entry = take_entry ? entries + j++ : NULL;
+        Argp_Range r = entry ? entry->r : ranges->items[i++];
+
+        if (size && r.lo <= out[size - 1].hi) {
+            const Argp_Range_Entry *later = !entry ? last : !last || entry->seq > last->seq ? entry : last;
+            size_t k;
+            // an entry overlapping several others is reported once
+            if (later == reported) {
+                if (r.hi > out[size - 1].hi) out[size - 1].hi = r.hi;
+                continue;
+            }
+            reported = later;
+            c->err = ARGP_ERROR_RANGE_OVERLAP;
+            c->unknown_option = later->token;
+            c->err_index = later->index;
+            if (argp_find_index(ranges, c->flags, sizeof(Argp_Flag), c->flag_capacity, &k))
+                c->err_flag = c->flags + k;
+            else if (argp_find_index(ranges, c->poss, sizeof(Argp_Pos), c->pos_capacity, &k))
+                c->err_pos = c->poss + k;
+            if (!argp_collect_error()) {
+                ARGP_FREE(out);
+                return false;
+            }
+            // the parse fails anyway, keep going to report the other overlaps
+            if (r.hi > out[size - 1].hi) out[size - 1].hi = r.hi;
+            last = later;
+            continue;
+        }
+
+        if (size && out[size - 1].hi + 1 == r.lo)
+            out[size - 1].hi = r.hi;
+        else
+            out[size++] = r;
+        if (entry || !last) last = entry;
+    }
+
+    ARGP_FREE(ranges->items);
+    ranges->items = out;
+    ranges->size = size;
+    ranges->_cap = cap;
+    return true;
+}
+
+static bool argp_push_range_entry(const Argp_Range_Entry *entry) {
+    Argp_Ctx *c = &argp_global_ctx;
+    if (c->range_entry_count == c->range_entry_cap) {
+        size_t cap = c->range_entry_cap ? c->range_entry_cap << 1 : ARGP_LIST_INIT_CAP;
+        Argp_Range_Entry *items = cap <= SIZE_MAX / sizeof(Argp_Range_Entry)
+                                      ? (Argp_Range_Entry *)ARGP_REALLOC(c->range_entries, cap * sizeof(Argp_Range_Entry))
+                                      : NULL;
+        if (items == NULL) return false;
+        c->range_entries = items;
+        c->range_entry_cap = cap;
+    }
+    c->range_entries[c->range_entry_count] = *entry;
+    c->range_entries[c->range_entry_count].seq = c->range_entry_count;
+    ++c->range_entry_count;
+    return true;
+}
+
+// checks the entries of arg and queues them, they are merged into the set once the parse is done
+static bool argp_parse_ranges(char *arg, Argp_Ranges *ranges) {
+    Argp_Ctx *c = &argp_global_ctx;
+
+    if (!arg) {
+        c->err = ARGP_ERROR_NO_VALUE;
+        return false;
+    }
+
+    size_t start = c->range_entry_count;
+    Argp_Error err = ARGP_NO_ERROR;
+    size_t index = 0;
+    for (const char *begin = arg;; ++index) {
+        const char *end = strchr(begin, ',');
+        size_t n = end ? (size_t)(end - begin) : strlen(begin);
+        const char *dash = (const char *)memchr(begin, '-', n);
+
+        Argp_Range_Entry entry = ARGP_ZERO(Argp_Range_Entry);
+        entry.ranges = ranges;
+        entry.token = arg;
+        entry.index = index;
+        err = argp_parse_digits(begin, dash ? (size_t)(dash - begin) : n, &entry.r.lo);
+        if (err == ARGP_NO_ERROR) {
+            if (dash)
+                err = argp_parse_digits(dash + 1, n - (size_t)(dash + 1 - begin), &entry.r.hi);
+            else
+                entry.r.hi = entry.r.lo;
+        }
+        if (err == ARGP_NO_ERROR && entry.r.lo > entry.r.hi) err = ARGP_ERROR_INVALID_RANGE;
+        if (err == ARGP_NO_ERROR && !argp_push_range_entry(&entry)) err = ARGP_ERROR_ALLOC;
+        if (err != ARGP_NO_ERROR || !end) break;
+        begin = end + 1;
+    }
+
+    if (err != ARGP_NO_ERROR) {
+        // none of the entries of a bad argument are kept
+        c->range_entry_count = start;
+        c->err = err;
+        c->unknown_option = arg;
+        c->err_index = index;
+        return false;
+    }
+    return true;
+}
+#endif  // ARGP_MINIMAL
+
+static bool argp_parse_flag(Argp_Flag *flag) {
+    Argp_Ctx *c = &argp_global_ctx;
+    switch (flag->type) {
+        case ARGP_BOOL: {
+            flag->val.as_bool = true;
+        } break;
+        case ARGP_UINT: {
+            char *arg = shift_args();
+#ifndef ARGP_MINIMAL
+            if (flag->lazy && !c->strict && arg) {
+                flag->raw = arg;
+                break;
+            }
+#endif
+            if (!argp_parse_uint(arg, &flag->val.as_uint)) {
+                c->err_flag = flag;
+                return false;
+            }
+        } break;
+        case ARGP_STR: {
+            char *arg = shift_args();
+            if (!argp_parse_str(arg, &flag->val.as_str)) {
                 c->err_flag = flag;
                 return false;
             }
         } break;
         case ARGP_ENUM: {
             char *arg = shift_args();
-            if (!argp_parse_enum(arg, &flag->val.as_enum, flag->enum_options, flag->option_count)) {
+#ifndef ARGP_MINIMAL
+            if (flag->lazy && !c->strict && arg) {
+                flag->raw = arg;
+                break;
+            }
+#endif
+            if (!argp_parse_enum(flag, arg, &flag->val.as_enum)) {
+                c->err_flag = flag;
+                return false;
+            }
+        } break;
+        case ARGP_ENUM_SET: {
+            char *arg = shift_args();
+            // the first occurrence replaces the default set
+            if (flag->source == ARGP_SOURCE_DEFAULT) flag->val.as_enum_set = 0;
+            if (!argp_parse_enum_set(flag, arg, &flag->val.as_enum_set)) {
                 c->err_flag = flag;
                 return false;
             }
@@ -789,12 +2577,79 @@ static bool argp_parse_flag(Argp_Flag *flag) {
                 return false;
             }
         } break;
+#ifndef ARGP_MINIMAL
+        case ARGP_MAP: {
+            char *arg = shift_args();
+            if (!argp_parse_map_entry(arg, &flag->val.as_map, flag->map_dup)) {
+                c->err_flag = flag;
+                return false;
+            }
+        } break;
+        case ARGP_RANGES: {
+            char *arg = shift_args();
+            if (!argp_parse_ranges(arg, &flag->val.as_ranges)) {
+                c->err_flag = flag;
+                return false;
+            }
+        } break;
+        case ARGP_SORTED_LIST: {
+            char *arg = shift_args();
+            if (!argp_parse_sorted_entry(arg, &flag->raw_list)) {
+                c->err_flag = flag;
+                return false;
+            }
+        } break;
+#endif
         default:
             ARGP_ASSERT(false && "Unreachable");
     }
     return true;
 }
 
+#ifndef ARGP_MINIMAL
+static bool argp_resolve_flag(Argp_Flag *flag) {
+    Argp_Ctx *c = &argp_global_ctx;
+    if (!flag->raw) return true;
+
+    bool ok = flag->type == ARGP_UINT
+                  ? argp_parse_uint(flag->raw, &flag->val.as_uint)
+                  : argp_parse_enum(flag, flag->raw, &flag->val.as_enum);
+    if (!ok) {
+        c->err_flag = flag;
+        return false;
+    }
+    flag->raw = NULL;
+    return true;
+}
+
+// resolves every pending lazy flag, before values are copied out
+static bool argp_resolve_all(void) {
+    Argp_Ctx *c = &argp_global_ctx;
+    for (size_t i = 0; i < c->flag_capacity; ++i) {
+        if (!argp_resolve_flag(c->flags + i)) return false;
+    }
+    return true;
+}
+
+static size_t argp_value_size(Argp_Type type) {
+    switch (type) {
+        case ARGP_BOOL: return sizeof(bool);
+        case ARGP_UINT: return sizeof(uint64_t);
+        case ARGP_STR: return sizeof(char *);
+        case ARGP_ENUM: return sizeof(size_t);
+        case ARGP_ENUM_SET: return sizeof(uint64_t);
+        case ARGP_LIST: return sizeof(Argp_List);
+        case ARGP_MAP: return sizeof(Argp_Map);
+        case ARGP_RANGES: return sizeof(Argp_Ranges);
+        case ARGP_UINT_LIST:
+        case ARGP_ENUM_LIST: return sizeof(Argp_Uint_List);
+        case ARGP_SORTED_LIST: return sizeof(Argp_Sorted_List);
+        default: ARGP_ASSERT(false && "Unreachable");
+    }
+    return 0;
+}
+#endif
+
 static bool argp_parse_pos(char *arg, Argp_Pos *pos) {
     Argp_Ctx *c = &argp_global_ctx;
     switch (pos->type) {
@@ -811,7 +2666,7 @@ static bool argp_parse_pos(char *arg, Argp_Pos *pos) {
             }
         } break;
         case ARGP_ENUM: {
-            if (!argp_parse_enum(arg, &pos->val.as_enum, pos->enum_options, pos->option_count)) {
+            if (!argp_parse_enum(pos, arg, &pos->val.as_enum)) {
                 c->err_pos = pos;
                 return false;
             }
@@ -822,105 +2677,2225 @@ static bool argp_parse_pos(char *arg, Argp_Pos *pos) {
                 return false;
             }
         } break;
+#ifndef ARGP_MINIMAL
+        case ARGP_RANGES: {
+            if (!argp_parse_ranges(arg, &pos->val.as_ranges)) {
+                c->err_pos = pos;
+                return false;
+            }
+        } break;
+        case ARGP_SORTED_LIST: {
+            if (!argp_parse_sorted_entry(arg, &pos->raw)) {
+                c->err_pos = pos;
+                return false;
+            }
+        } break;
+        case ARGP_UINT_LIST:
+        case ARGP_ENUM_LIST: {
+            if (pos->parallel) {
+                if (!argp_parse_list_entry(arg, &pos->raw)) {
+                    c->err_pos = pos;
+                    return false;
+                }
+                break;
+            }
+
+            uint64_t v;
+            Argp_Error err = argp_convert_entry(pos, arg, &v);
+            if (err != ARGP_NO_ERROR) {
+                c->err = err;
+                c->err_pos = pos;
+                c->unknown_option = arg;
+                c->err_index = pos->val.as_uint_list.size;
+                return false;
+            }
+            if (!argp_uint_list_push(&pos->val.as_uint_list, v)) {
+                c->err_pos = pos;
+                return false;
+            }
+        } break;
+#endif
         default:
             ARGP_ASSERT(false && "Unreachable");
     }
     return true;
 }
 
-bool argp_parse_args(void) {
-    Argp_Ctx *c = &argp_global_ctx;
-
-    char *arg;
-    while ((arg = shift_args())) {
-        size_t n = strlen(arg);
+#ifndef ARGP_MINIMAL
+// Runs task over [0, n) in chunks of grain items on a pool of up to ARGP_THREAD_COUNT - 1
+// workers, started by the first call that has more than one chunk and kept for later ones.
+// The calling thread takes part. Every participant owns a range of chunks, takes them from
+// its front and, once it is empty, steals single chunks from the back of the others.
+typedef void (*Argp_Task)(void *data, size_t begin, size_t end);
 
-        Argp_Flag *flag = NULL;
-        if (!(flag = try_short_name(arg, n)))
-            flag = try_long_name(arg, n);
+// begin << 32 | end of the chunks a participant still owns, a cache line each
+typedef struct {
+    uint64_t range;
+    char pad[56];
+} Argp_Chunk_Range;
 
-        if (flag) {
-            if (flag == c->command_ctx->help_flag) {
-                argp_print_usage(stdout);
-                exit(0);
-            }
-            if (!argp_parse_flag(flag))
-                return false;
-            continue;
+typedef struct {
+    Argp_Task task;
+    void *data;
+    size_t n;
+    size_t grain;
+    size_t slots;  // participants, the caller is slot 0
+    Argp_Chunk_Range ranges[ARGP_THREAD_COUNT];
+} Argp_Parallel;
+
+// takes the first chunk of range, or with back the last, false if range is empty
+static bool argp_chunk_take(uint64_t *range, bool back, size_t *chunk) {
+    uint64_t r = __atomic_load_n(range, __ATOMIC_ACQUIRE);
+    for (;;) {
+        uint64_t begin = r >> 32, end = r & 0xffffffffu;
+        if (begin >= end) return false;
+        uint64_t next = back ? begin << 32 | (end - 1) : (begin + 1) << 32 | end;
+        if (__atomic_compare_exchange_n(range, &r, next, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            *chunk = (size_t)(back ? end - 1 : begin);
+            return true;
         }
+    }
+}
 
-        Argp_Command *selected_command = NULL;
+// runs chunks until every range is empty, ranges only shrink so one failed pass over all of
+// them means there is nothing left
+static void argp_parallel_work(Argp_Parallel *p, size_t self) {
+    for (;;) {
+        size_t chunk;
+        bool got = argp_chunk_take(&p->ranges[self].range, false, &chunk);
+        for (size_t k = 1; !got && k < p->slots; ++k)
+            got = argp_chunk_take(&p->ranges[(self + k) % p->slots].range, true, &chunk);
+        if (!got) return;
+
+        size_t begin = chunk * p->grain;
+        size_t end = p->n - begin < p->grain ? p->n : begin + p->grain;
+        p->task(p->data, begin, end);
+    }
+}
 
-        for (size_t i = 0; i < c->command_capacity; ++i) {
-            Argp_Command *command = c->commands + i;
-            if (command->parent_command == c->command_ctx &&
-                strcmp(arg, command->name) == 0) {
-                selected_command = command;
-                break;
-            }
-        }
+#ifndef ARGP_NO_THREADS
+typedef struct {
+    pthread_mutex_t run;   // one parallel_for at a time
+    pthread_mutex_t lock;  // the fields below
+    pthread_cond_t wake, done;
+    pid_t pid;             // process the workers run in, a forked child has none
+    size_t started;
+    size_t ready;          // workers waiting for jobs, a job is only posted once all are
+    uint64_t generation;   // bumped for every job, workers wait for it to change
+    Argp_Parallel *job;
+    size_t busy;           // workers still on the current job
+} Argp_Pool;
+
+static Argp_Pool argp_pool = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+                              PTHREAD_COND_INITIALIZER,  PTHREAD_COND_INITIALIZER,
+                              0, 0, 0, 0, NULL, 0};
+
+static void *argp_pool_worker(void *arg) {
+    size_t self = (size_t)(uintptr_t)arg;
+    Argp_Pool *pool = &argp_pool;
+    pthread_mutex_lock(&pool->lock);
+    uint64_t seen = pool->generation;
+    if (++pool->ready == pool->started) pthread_cond_signal(&pool->done);
+    for (;;) {
+        while (pool->generation == seen) pthread_cond_wait(&pool->wake, &pool->lock);
+        seen = pool->generation;
+        Argp_Parallel *job = pool->job;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (self < job->slots) argp_parallel_work(job, self);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) pthread_cond_signal(&pool->done);
+    }
+    return NULL;
+}
 
-        if (selected_command) {
-            selected_command->val = true;
-            c->command_ctx = selected_command;
-            continue;
-        }
+// starts workers up to want, keeps the ones already running, the number running after
+static size_t argp_pool_start(size_t want) {
+    Argp_Pool *pool = &argp_pool;
+    pid_t pid = getpid();
+    if (pool->pid != pid) {
+        // the workers of the parent do not exist in a forked child, and the locks may have
+        // been copied while held
+        Argp_Pool fresh = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+                           PTHREAD_COND_INITIALIZER,  PTHREAD_COND_INITIALIZER,
+                           0, 0, 0, 0, NULL, 0};
+        *pool = fresh;
+        pool->pid = pid;
+    }
+    pthread_mutex_lock(&pool->run);
+
+    while (pool->started < want) {
+        pthread_t thread;
+        // slot 0 is the caller
+        if (pthread_create(&thread, NULL, argp_pool_worker, (void *)(uintptr_t)(pool->started + 1)) != 0) break;
+        pthread_detach(thread);
+        pthread_mutex_lock(&pool->lock);
+        ++pool->started;
+        pthread_mutex_unlock(&pool->lock);
+    }
 
-        Argp_Pos *selected_pos = NULL;
+    // a worker that first looked at the generation after the next job was posted would
+    // wait for the one after it
+    pthread_mutex_lock(&pool->lock);
+    while (pool->ready < pool->started) pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+    return pool->started;
+}
+#endif
 
-        for (size_t i = 0; i < c->pos_capacity; ++i) {
-            Argp_Pos *pos = c->poss + i;
-            if (pos->command == c->command_ctx &&
-                (pos->type == ARGP_LIST || !pos->seen)) {
-                selected_pos = pos;
-                break;
-            }
+static void argp_parallel_for(size_t n, size_t grain, Argp_Task task, void *data) {
+    Argp_Parallel p = ARGP_ZERO(Argp_Parallel);
+    p.task = task;
+    p.data = data;
+    p.n = n;
+    p.grain = grain ? grain : 1;
+    size_t chunks = (n + p.grain - 1) / p.grain;
+    // chunk indices are 32 bits in a range
+    if (chunks > 0xffffffffu) {
+        p.grain = n / 0xffffffffu + 1;
+        chunks = (n + p.grain - 1) / p.grain;
+    }
+    p.slots = 1;
+
+#ifndef ARGP_NO_THREADS
+    long cpus = ARGP_CPU_COUNT;
+    size_t thread_count = cpus > 0 ? (size_t)cpus : 1;
+    if (thread_count > ARGP_THREAD_COUNT) thread_count = ARGP_THREAD_COUNT;
+    if (thread_count > chunks) thread_count = chunks;
+
+    if (thread_count > 1) {
+        Argp_Pool *pool = &argp_pool;
+        size_t workers = argp_pool_start(thread_count - 1);
+        p.slots = workers + 1 < thread_count ? workers + 1 : thread_count;
+        for (size_t i = 0; i < p.slots; ++i) {
+            uint64_t begin = chunks * i / p.slots, end = chunks * (i + 1) / p.slots;
+            p.ranges[i].range = begin << 32 | end;
         }
 
-        if (selected_pos == NULL) {
-            c->err = ARGP_ERROR_UNKNOWN;
-            c->unknown_option = arg;
-            return false;
-        }
+        // every worker checks in, the ones past p.slots only to be counted
+        pthread_mutex_lock(&pool->lock);
+        pool->job = &p;
+        pool->busy = workers;
+        ++pool->generation;
+        pthread_cond_broadcast(&pool->wake);
+        pthread_mutex_unlock(&pool->lock);
+
+        argp_parallel_work(&p, 0);
+
+        pthread_mutex_lock(&pool->lock);
+        while (pool->busy) pthread_cond_wait(&pool->done, &pool->lock);
+        pool->job = NULL;
+        pthread_mutex_unlock(&pool->lock);
+        pthread_mutex_unlock(&pool->run);
+        return;
+    }
+#endif
+    p.ranges[0].range = (uint64_t)chunks;
+    argp_parallel_work(&p, 0);
+}
 
-        if (!argp_parse_pos(arg, selected_pos))
-            return false;
+#define ARGP_CONVERT_GRAIN 4096
 
-        selected_pos->seen = true;
+typedef struct {
+    const Argp_Pos *pos;
+    uint64_t *out;
+    unsigned char *err;  // error of each entry, ARGP_NO_ERROR if it converted
+    size_t *chunk_err;   // failed entries of each chunk
+    size_t grain;
+} Argp_Convert_Job;
+
+static void argp_convert_task(void *data, size_t begin, size_t end) {
+    Argp_Convert_Job *job = (Argp_Convert_Job *)data;
+    size_t failed = 0;
+    for (size_t i = begin; i < end; ++i) {
+        Argp_Error err = argp_convert_entry(job->pos, job->pos->raw.items[i], job->out + i);
+        job->err[i] = (unsigned char)err;
+        failed += err != ARGP_NO_ERROR;
     }
+    job->chunk_err[begin / job->grain] = failed;
+}
 
-    for (size_t i = 0; i < c->pos_capacity; ++i) {
-        Argp_Pos *pos = c->poss + i;
-        if (pos->command != c->command_ctx) continue;
-        if (pos->req == ARGP_REQUIRED && !pos->seen) {
-            c->err = ARGP_ERROR_NO_VALUE;
+// reports the failed entries in index order and drops them from the list, as the serial path
+// does, false once an error is not collected
+static bool argp_convert_errors(Argp_Pos *pos, const unsigned char *err) {
+    Argp_Ctx *c = &argp_global_ctx;
+    Argp_Uint_List *list = &pos->val.as_uint_list;
+    size_t w = 0;
+    for (size_t i = 0; i < pos->raw.size; ++i) {
+        if (err[i] == ARGP_NO_ERROR) {
+            list->items[w++] = list->items[i];
+            continue;
+        }
+        list->size = w;
+        c->err = (Argp_Error)err[i];
+        c->err_pos = pos;
+        c->unknown_option = pos->raw.items[i];
+        c->err_index = i;
+        if (!argp_collect_error()) return false;
+    }
+    list->size = w;
+    return true;
+}
+
+// converts the tokens collected for parallel lists into their preallocated slots, lists
+// shorter than ARGP_PARALLEL_MIN are converted on the calling thread
+static bool argp_convert_lists(void) {
+    Argp_Ctx *c = &argp_global_ctx;
+
+    for (size_t i = 0; i < c->pos_capacity; ++i) {
+        Argp_Pos *pos = c->poss + i;
+        size_t n = pos->raw.size;
+        if (!pos->parallel || n == 0) continue;
+
+        Argp_Uint_List *list = &pos->val.as_uint_list;
+        size_t grain = n < ARGP_PARALLEL_MIN ? n : ARGP_CONVERT_GRAIN;
+        size_t chunks = (n + grain - 1) / grain;
+        uint64_t *items = n <= SIZE_MAX / sizeof(uint64_t)
+                              ? (uint64_t *)ARGP_REALLOC(list->items, n * sizeof(uint64_t))
+                              : NULL;
+        if (items) list->items = items;
+        unsigned char *err = items ? (unsigned char *)ARGP_REALLOC(NULL, n) : NULL;
+        size_t *chunk_err = err ? (size_t *)ARGP_REALLOC(NULL, chunks * sizeof(size_t)) : NULL;
+        if (chunk_err == NULL) {
+            ARGP_FREE(err);
+            c->err = ARGP_ERROR_ALLOC;
             c->err_pos = pos;
             return false;
         }
+        list->_cap = n;
+
+        Argp_Convert_Job job = {pos, items, err, chunk_err, grain};
+        if (chunks == 1)
+            argp_convert_task(&job, 0, n);
+        else
+            argp_parallel_for(n, grain, argp_convert_task, &job);
+
+        size_t failed = 0;
+        for (size_t k = 0; k < chunks; ++k) failed += chunk_err[k];
+        ARGP_FREE(chunk_err);
+
+        bool ok = failed == 0 || argp_convert_errors(pos, err);
+        if (failed == 0) list->size = n;
+        ARGP_FREE(err);
+        argp_free_list(&pos->raw);
+        pos->raw = ARGP_ZERO(Argp_List);
+        if (!ok) return false;
     }
+    return true;
+}
+
+static int argp_range_entry_cmp(const void *a, const void *b) {
+    const Argp_Range_Entry *x = (const Argp_Range_Entry *)a, *y = (const Argp_Range_Entry *)b;
+    if (x->ranges != y->ranges) return (uintptr_t)x->ranges < (uintptr_t)y->ranges ? -1 : 1;
+    if (x->r.lo != y->r.lo) return x->r.lo < y->r.lo ? -1 : 1;
+    return x->seq < y->seq ? -1 : x->seq > y->seq;
+}
 
+// merges the queued range entries into their sets, one sort and one pass per set
+// however many times a range argument is repeated
+static bool argp_merge_ranges(void) {
+    Argp_Ctx *c = &argp_global_ctx;
+    size_t n = c->range_entry_count;
+    c->range_entry_count = 0;
+    if (n == 0) return true;
+
+    qsort(c->range_entries, n, sizeof(Argp_Range_Entry), argp_range_entry_cmp);
+    size_t end;
+    for (size_t begin = 0; begin < n; begin = end) {
+        Argp_Ranges *ranges = c->range_entries[begin].ranges;
+        for (end = begin + 1; end < n && c->range_entries[end].ranges == ranges; ++end) {}
+        if (!argp_ranges_merge(ranges, c->range_entries + begin, end - begin)) return false;
+    }
     return true;
 }
 
-void argp_free_list(Argp_List *list) { ARGP_FREE(list->items); }
+// encodes the entries collected for sorted lists, then drops the buffers of @file entries
+static bool argp_sort_lists(void) {
+    Argp_Ctx *c = &argp_global_ctx;
+    bool ok = true;
 
-const char *argp_name(void *val) {
+    for (size_t i = 0; ok && i < c->flag_capacity; ++i) {
+        Argp_Flag *flag = c->flags + i;
+        if (flag->type != ARGP_SORTED_LIST || flag->raw_list.size == 0) continue;
+        ok = argp_sort_list(&flag->raw_list, &flag->val.as_sorted);
+        if (!ok) c->err_flag = flag;
+    }
+    for (size_t i = 0; ok && i < c->pos_capacity; ++i) {
+        Argp_Pos *pos = c->poss + i;
+        if (pos->type != ARGP_SORTED_LIST || pos->raw.size == 0) continue;
+        ok = argp_sort_list(&pos->raw, &pos->val.as_sorted);
+        if (!ok) c->err_pos = pos;
+    }
+
+    argp_free_ingested();
+    return ok;
+}
+
+// drops the tokens still waiting for conversion or encoding when a parse stopped early
+static void argp_free_pending(void) {
     Argp_Ctx *c = &argp_global_ctx;
-    for (size_t i = 0; i < ARGP_FLAG_CAP; ++i) {
-        const Argp_Flag *flag = c->flags + i;
-        if (&flag->val == val) {
-            if (flag->long_name)
-                return flag->long_name;
-            else
-                return flag->short_name;
+    for (size_t i = 0; i < c->flag_capacity; ++i) {
+        argp_free_list(&c->flags[i].raw_list);
+        c->flags[i].raw_list = ARGP_ZERO(Argp_List);
+    }
+    for (size_t i = 0; i < c->pos_capacity; ++i) {
+        argp_free_list(&c->poss[i].raw);
+        c->poss[i].raw = ARGP_ZERO(Argp_List);
+    }
+    argp_free_ingested();
+}
+
+typedef struct {
+    const char *path;
+    unsigned check;
+    Argp_Error err;
+    bool stated;  // mode or err already filled by the io_uring batch
+    uint16_t mode;
+
+    Argp_Flag *flag;
+    Argp_Pos *pos;
+    size_t index;
+} Argp_Path_Job;
+
+static Argp_Error argp_stat_path(const char *path, uint16_t *mode) {
+#ifdef ARGP_HAVE_STATX
+    struct statx st;
+    if (syscall(SYS_statx, AT_FDCWD, path, 0, STATX_TYPE, &st) == 0) {
+        *mode = st.stx_mode;
+        return ARGP_NO_ERROR;
+    }
+    if (errno != ENOSYS) return argp_path_error(errno);
+#endif
+    struct stat sb;
+    if (stat(path, &sb) != 0) return argp_path_error(errno);
+    *mode = (uint16_t)sb.st_mode;
+    return ARGP_NO_ERROR;
+}
+
+static Argp_Error argp_check_path(Argp_Path_Job *job) {
+    if (!job->stated) job->err = argp_stat_path(job->path, &job->mode);
+    if (job->err != ARGP_NO_ERROR) return job->err;
+
+    unsigned check = job->check;
+    if ((check & ARGP_PATH_FILE) && !S_ISREG(job->mode)) return ARGP_ERROR_PATH_NOT_FILE;
+    if ((check & ARGP_PATH_DIR) && !S_ISDIR(job->mode)) return ARGP_ERROR_PATH_NOT_DIR;
+    if ((check & ARGP_PATH_READABLE) && access(job->path, R_OK) != 0) return argp_path_error(errno);
+    return ARGP_NO_ERROR;
+}
+
+static void argp_check_path_task(void *data, size_t begin, size_t end) {
+    Argp_Path_Job *jobs = (Argp_Path_Job *)data;
+    for (size_t i = begin; i < end; ++i)
+        jobs[i].err = argp_check_path(jobs + i);
+}
+
+#ifdef ARGP_HAVE_IO_URING
+#define ARGP_URING_ENTRIES 256
+#define ARGP_URING_MIN 32  // paths below which setting up a ring costs more than it saves
+
+typedef struct {
+    int fd;
+    void *sq_ring, *cq_ring;
+    size_t sq_size, cq_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe *cqes;
+} Argp_Uring;
+
+static void argp_uring_close(Argp_Uring *u) {
+    if (u->sqes) munmap(u->sqes, u->sqes_size);
+    if (u->cq_ring && u->cq_ring != u->sq_ring) munmap(u->cq_ring, u->cq_size);
+    if (u->sq_ring) munmap(u->sq_ring, u->sq_size);
+    close(u->fd);
+}
+
+static void *argp_uring_map(int fd, size_t size, uint64_t offset) {
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, (off_t)offset);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+// true if the kernel runs IORING_OP_STATX on this ring, seccomp or an old kernel can refuse it
+static bool argp_uring_has_statx(int fd) {
+    size_t size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = (struct io_uring_probe *)ARGP_REALLOC(NULL, size);
+    if (probe == NULL) return false;
+    memset(probe, 0, size);
+
+    bool ok = syscall(SYS_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) == 0 &&
+              probe->ops_len > IORING_OP_STATX && (probe->ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED);
+    ARGP_FREE(probe);
+    return ok;
+}
+
+static bool argp_uring_open(Argp_Uring *u) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(u, 0, sizeof(*u));
+    u->fd = (int)syscall(SYS_io_uring_setup, ARGP_URING_ENTRIES, &p);
+    if (u->fd < 0) return false;
+    if (!argp_uring_has_statx(u->fd)) {
+        close(u->fd);
+        return false;
+    }
+
+    u->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    u->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (u->cq_size > u->sq_size) u->sq_size = u->cq_size;
+        u->cq_size = u->sq_size;
+    }
+    u->sq_ring = argp_uring_map(u->fd, u->sq_size, IORING_OFF_SQ_RING);
+    u->cq_ring = (p.features & IORING_FEAT_SINGLE_MMAP) ? u->sq_ring
+                                                        : argp_uring_map(u->fd, u->cq_size, IORING_OFF_CQ_RING);
+    u->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    u->sqes = (struct io_uring_sqe *)argp_uring_map(u->fd, u->sqes_size, IORING_OFF_SQES);
+    if (!u->sq_ring || !u->cq_ring || !u->sqes) {
+        argp_uring_close(u);
+        return false;
+    }
+
+    char *sq = (char *)u->sq_ring, *cq = (char *)u->cq_ring;
+    u->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    u->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    u->sq_array = (unsigned *)(sq + p.sq_off.array);
+    u->cq_head = (unsigned *)(cq + p.cq_off.head);
+    u->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    u->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    return true;
+}
+
+// -1 before the first batch, then whether io_uring_setup and the statx probe succeeded, so a
+// kernel without it is asked once per process
+static int argp_uring_usable = -1;
+
+// stats the paths of jobs in waves of ARGP_URING_ENTRIES statx submissions and marks every job
+// it filled as stated, the others are stated one by one by argp_check_path
+// the kernel runs IORING_OP_STATX on its io-wq workers, which costs more than a statx call for
+// paths in the dentry cache (100k cached paths: about 175 ms against 95 ms with Linux 6.18 on
+// one CPU), so it is only built with ARGP_IO_URING, for paths that are mostly not cached
+static void argp_uring_stat_paths(Argp_Path_Job *jobs, size_t count) {
+    if (count < ARGP_URING_MIN || __atomic_load_n(&argp_uring_usable, __ATOMIC_RELAXED) == 0) return;
+
+    Argp_Uring u;
+    bool usable = argp_uring_open(&u);
+    __atomic_store_n(&argp_uring_usable, usable, __ATOMIC_RELAXED);
+    if (!usable) return;
+
+    struct statx *bufs = (struct statx *)ARGP_REALLOC(NULL, ARGP_URING_ENTRIES * sizeof(struct statx));
+    if (bufs == NULL) {
+        argp_uring_close(&u);
+        return;
+    }
+
+    unsigned in_flight = 0;
+    for (size_t begin = 0; begin < count; begin += ARGP_URING_ENTRIES) {
+        unsigned n = count - begin < ARGP_URING_ENTRIES ? (unsigned)(count - begin) : ARGP_URING_ENTRIES;
+        unsigned tail = *u.sq_tail, mask = *u.sq_mask;
+        for (unsigned k = 0; k < n; ++k) {
+            unsigned slot = (tail + k) & mask;
+            struct io_uring_sqe *sqe = u.sqes + slot;
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = (uint64_t)(uintptr_t)jobs[begin + k].path;
+            sqe->len = STATX_TYPE;
+            sqe->off = (uint64_t)(uintptr_t)(bufs + k);
+            sqe->user_data = k;
+            u.sq_array[slot] = slot;
+        }
+        __atomic_store_n(u.sq_tail, tail + n, __ATOMIC_RELEASE);
+
+        unsigned to_submit = n, done = 0;
+        while (done < n) {
+            long ret = syscall(SYS_io_uring_enter, u.fd, to_submit, n - done, IORING_ENTER_GETEVENTS, NULL, 0);
+            if (ret < 0) {
+                if (errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+                break;
+            }
+            to_submit -= (unsigned)ret;
+
+            unsigned head = *u.cq_head, cq_tail = __atomic_load_n(u.cq_tail, __ATOMIC_ACQUIRE);
+            for (; head != cq_tail; ++head, ++done) {
+                struct io_uring_cqe *cqe = u.cqes + (head & *u.cq_mask);
+                Argp_Path_Job *job = jobs + begin + cqe->user_data;
+                if (cqe->res == -ENOSYS || cqe->res == -EINVAL) continue;  // left to argp_check_path
+                job->stated = true;
+                if (cqe->res < 0) job->err = argp_path_error(-cqe->res);
+                else job->mode = bufs[cqe->user_data].stx_mode;
+            }
+            __atomic_store_n(u.cq_head, head, __ATOMIC_RELEASE);
+        }
+        in_flight = n - done;
+        if (in_flight) break;
+    }
+
+    // a submission still in flight may yet write to its buffer, which is then left allocated
+    if (!in_flight) ARGP_FREE(bufs);
+    argp_uring_close(&u);
+}
+#endif  // ARGP_HAVE_IO_URING
+
+static bool argp_add_path_jobs(Argp_Path_Job **jobs, size_t *count, size_t *cap, unsigned check,
+                               Argp_Type type, const Argp_Value *val, Argp_Flag *flag, Argp_Pos *pos) {
+    size_t n = type == ARGP_LIST ? val->as_list.size : 1;
+    if (*count + n > *cap) {
+        size_t new_cap = *cap ? *cap : ARGP_LIST_INIT_CAP;
+        while (new_cap < *count + n) new_cap <<= 1;
+
+        Argp_Path_Job *items = (Argp_Path_Job *)ARGP_REALLOC(*jobs, new_cap * sizeof(Argp_Path_Job));
+        if (items == NULL) return false;
+        *jobs = items;
+        *cap = new_cap;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        Argp_Path_Job *job = *jobs + (*count)++;
+        *job = ARGP_ZERO(Argp_Path_Job);
+        job->path = type == ARGP_LIST ? val->as_list.items[i] : val->as_str;
+        job->check = check;
+        job->flag = flag;
+        job->pos = pos;
+        job->index = i;
+    }
+    return true;
+}
+
+// validates every path given on the command line in one batch,
+// the error reported is the first one in the order the arguments were defined
+static bool argp_check_paths(void) {
+    Argp_Ctx *c = &argp_global_ctx;
+
+    Argp_Path_Job *jobs = NULL;
+    size_t count = 0, cap = 0;
+    bool ok = true;
+
+    for (size_t i = 0; ok && i < c->flag_capacity; ++i) {
+        Argp_Flag *flag = c->flags + i;
+        if (!flag->path_check || flag->source == ARGP_SOURCE_DEFAULT) continue;
+        ok = argp_add_path_jobs(&jobs, &count, &cap, flag->path_check, flag->type, &flag->val, flag, NULL);
+    }
+    for (size_t i = 0; ok && i < c->pos_capacity; ++i) {
+        Argp_Pos *pos = c->poss + i;
+        if (!pos->path_check || pos->source == ARGP_SOURCE_DEFAULT) continue;
+        ok = argp_add_path_jobs(&jobs, &count, &cap, pos->path_check, pos->type, &pos->val, NULL, pos);
+    }
+
+    if (!ok) {
+        ARGP_FREE(jobs);
+        c->err = ARGP_ERROR_ALLOC;
+        return false;
+    }
+
+#ifdef ARGP_HAVE_IO_URING
+    argp_uring_stat_paths(jobs, count);
+#endif
+    argp_parallel_for(count, 64, argp_check_path_task, jobs);
+
+    for (size_t i = 0; ok && i < count; ++i) {
+        if (jobs[i].err == ARGP_NO_ERROR) continue;
+        c->err = jobs[i].err;
+        c->err_flag = jobs[i].flag;
+        c->err_pos = jobs[i].pos;
+        c->err_index = jobs[i].index;
+        c->unknown_option = jobs[i].path;
+        ok = argp_collect_error();
+    }
+
+    ARGP_FREE(jobs);
+    return ok;
+}
+#endif  // ARGP_MINIMAL
+
+// only ever writes to slots that were already read
+static void argp_pass(char *arg) {
+    Argp_Ctx *c = &argp_global_ctx;
+    c->argv[c->pass_argc++] = arg;
+}
+
+static bool argp_push_pos_token(char *arg) {
+    Argp_Ctx *c = &argp_global_ctx;
+    if (c->pos_token_count == c->pos_token_cap) {
+        size_t cap = c->pos_token_cap ? c->pos_token_cap << 1 : ARGP_LIST_INIT_CAP;
+        Argp_Pos_Token *tokens = cap <= SIZE_MAX / sizeof(Argp_Pos_Token)
+                                     ? (Argp_Pos_Token *)ARGP_REALLOC(c->pos_tokens, cap * sizeof(Argp_Pos_Token))
+                                     : NULL;
+        if (tokens == NULL) {
+            c->err = ARGP_ERROR_ALLOC;
+            return false;
+        }
+        c->pos_tokens = tokens;
+        c->pos_token_cap = cap;
+    }
+    Argp_Pos_Token *token = c->pos_tokens + c->pos_token_count++;
+    token->arg = arg;
+    token->pass_at = c->pass_argc;
+    token->argv_index = (int)(c->rest_argv - c->parse_argv) - 1;
+    return true;
+}
+
+// puts the tokens in [from, count) back among the passed through tokens where they were read,
+// merging from the back only writes to slots that were already read
+static void argp_pass_pos_tokens(size_t from) {
+    Argp_Ctx *c = &argp_global_ctx;
+    int w = c->pass_argc + (int)(c->pos_token_count - from);
+    int r = c->pass_argc;
+    for (size_t i = c->pos_token_count; i-- > from;) {
+        const Argp_Pos_Token *token = c->pos_tokens + i;
+        while (r > token->pass_at) c->argv[--w] = c->argv[--r];
+        c->argv[--w] = token->arg;
+    }
+    c->pass_argc += (int)(c->pos_token_count - from);
+}
+
+// gives the buffered tokens to the positional arguments of the current command in one pass,
+// each takes as many as it can while leaving the minimum of the ones after it
+// once a subcommand is selected the positionals of its parent may be left without a value
+static bool argp_assign_positionals(bool known, bool subcommand) {
+    Argp_Ctx *c = &argp_global_ctx;
+    Argp_Command *command = c->command_ctx;
+    size_t count = c->pos_token_count;
+    if (!command) return true;
+
+    size_t rest_min = 0;
+    for (size_t i = 0; i < c->pos_capacity; ++i) {
+        if (c->poss[i].command != command) continue;
+        size_t min, max;
+        argp_pos_nargs(c->poss + i, &min, &max);
+        rest_min += min;
+    }
+
+    size_t t = 0;
+    for (command->cur_pos = 0; command->cur_pos < c->pos_capacity; ++command->cur_pos) {
+        Argp_Pos *pos = c->poss + command->cur_pos;
+        if (pos->command != command) continue;
+
+        size_t min, max;
+        argp_pos_nargs(pos, &min, &max);
+        rest_min -= min;
+
+        size_t left = count - t, take;
+        if (left >= rest_min + min)
+            take = left - rest_min < max ? left - rest_min : max;
+        else
+            take = left < min ? left : min;
+
+        for (size_t k = 0; k < take; ++k) {
+            if (argp_parse_pos(c->pos_tokens[t + k].arg, pos)) continue;
+            // entries that failed before are not in the list
+            if (pos->type == ARGP_UINT_LIST || pos->type == ARGP_ENUM_LIST) c->err_index = k;
+            c->err_argv_index = c->pos_tokens[t + k].argv_index;
+            if (!argp_collect_error()) return false;
+        }
+        if (take) pos->source = ARGP_SOURCE_ARGV;
+        t += take;
+
+        if (take < min && !subcommand) {
+            c->err = ARGP_ERROR_NO_VALUE;
+            c->err_pos = pos;
+            if (!argp_collect_error()) return false;
+        }
+    }
+
+    if (t < count) {
+        if (!known) {
+            for (; t < count; ++t) {
+                c->err = ARGP_ERROR_UNKNOWN;
+                c->unknown_option = c->pos_tokens[t].arg;
+                c->err_argv_index = c->pos_tokens[t].argv_index;
+                if (!argp_collect_error()) return false;
+            }
+            c->pos_token_count = 0;
+            return true;
+        }
+        argp_pass_pos_tokens(t);
+    }
+
+    c->pos_token_count = 0;
+    return true;
+}
+
+#ifndef ARGP_MINIMAL
+// errors in argv order, the ones without a token last
+static void argp_sort_error_records(void) {
+    Argp_Ctx *c = &argp_global_ctx;
+    for (size_t i = 1; i < c->error_count; ++i) {
+        Argp_Error_Record r = c->errors[i];
+        unsigned key = (unsigned)r.argv_index;
+        size_t j = i;
+        for (; j > 0 && (unsigned)c->errors[j - 1].argv_index > key; --j) c->errors[j] = c->errors[j - 1];
+        c->errors[j] = r;
+    }
+}
+#endif
+
+static bool argp_parse(bool known) {
+    Argp_Ctx *c = &argp_global_ctx;
+    c->pass_argc = 1;
+    c->pos_token_count = 0;
+    c->parse_argv = c->rest_argv;
+    c->parse_argc = c->rest_argc;
+    c->err_argv_index = -1;
+    if (!argp_names_build()) return false;
+#ifndef ARGP_MINIMAL
+    c->range_entry_count = 0;
+    c->error_count = 0;
+    c->error_total = 0;
+#endif
+
+    // argv[0] selects the program whatever it says, a reload may run under another name
+    if (shift_args()) {
+        c->program_command->val = true;
+        c->command_ctx = c->program_command;
+    }
+
+    char *arg;
+    while ((arg = shift_args())) {
+        size_t n = strlen(arg);
+
+        if (known && c->command_ctx && strcmp(arg, "--") == 0) {
+            while ((arg = shift_args())) argp_pass(arg);
+            break;
+        }
+
+        Argp_Flag *flag = NULL;
+        if (!(flag = try_short_name(arg, n)))
+            flag = try_long_name(arg, n);
+
+        if (flag) {
+#ifndef ARGP_MINIMAL
+            if (flag == c->command_ctx->help_flag) {
+                argp_print_usage(stdout);
+                exit(0);
+            }
+#endif
+            if (!argp_parse_flag(flag)) {
+                c->err_argv_index = (int)(c->rest_argv - c->parse_argv) - 1;
+                if (!argp_collect_error()) return false;
+                continue;
+            }
+#ifndef ARGP_MINIMAL
+            if (flag == c->help_search_flag) {
+                argp_help_search(stdout, flag->val.as_str);
+                exit(0);
+            }
+#endif
+            flag->source = ARGP_SOURCE_ARGV;
+            continue;
+        }
+
+        if (known && c->command_ctx && arg[0] == '-' && arg[1]) {
+            argp_pass(arg);
+            continue;
+        }
+
+        size_t command_index = argp_name_find(ARGP_NAME_COMMAND, c->command_ctx, arg, n);
+        if (command_index != SIZE_MAX) {
+            Argp_Command *selected_command = c->commands + command_index;
+            // the positionals of the parent all come before the command
+            if (!argp_assign_positionals(known, true)) return false;
+            selected_command->val = true;
+            c->command_ctx = selected_command;
+            continue;
+        }
+
+        if (!c->command_ctx) {
+            c->err = ARGP_ERROR_UNKNOWN;
+            c->unknown_option = arg;
+            return false;
         }
+
+        if (!argp_push_pos_token(arg)) return false;
+    }
+
+    if (!argp_assign_positionals(known, false)) return false;
+
+#ifdef ARGP_MINIMAL
+    return true;
+#else
+    if (!argp_convert_lists() || !argp_merge_ranges() || !argp_sort_lists() || !argp_check_paths()) return false;
+    if (c->error_total == 0) return true;
+
+    argp_sort_error_records();
+    c->err = c->errors[0].code;
+    return false;
+#endif
+}
+
+// drops what only the parse needed, then copies the bound values out once it succeeded
+static bool argp_finish(bool ok) {
+    Argp_Ctx *c = &argp_global_ctx;
+    ARGP_FREE(c->pos_tokens);
+    c->pos_tokens = NULL;
+    c->pos_token_count = c->pos_token_cap = 0;
+
+#ifndef ARGP_MINIMAL
+    argp_free_pending();
+    ok = ok && argp_bind(c->bind_base);
+#endif
+    return ok;
+}
+
+bool argp_parse_args(void) { return argp_finish(argp_parse(false)); }
+
+bool argp_parse_known_args(int *argc, char ***argv) {
+    Argp_Ctx *c = &argp_global_ctx;
+    if (!argp_finish(argp_parse(true))) return false;
+
+    c->argv[c->pass_argc] = NULL;
+    *argc = c->pass_argc;
+    *argv = c->argv;
+    return true;
+}
+
+Argp_Error argp_error(void) { return argp_global_ctx.err; }
+
+#ifndef ARGP_MINIMAL
+size_t argp_error_records(const Argp_Error_Record **records, size_t *total) {
+    Argp_Ctx *c = &argp_global_ctx;
+    *records = c->errors;
+    if (total) *total = c->error_total;
+    return c->error_count;
+}
+
+bool argp_bind(void *base) {
+    Argp_Ctx *c = &argp_global_ctx;
+    c->bind_base = (char *)base;
+    if (!base) return true;
+
+    for (size_t i = 0; i < c->command_capacity; ++i) {
+        const Argp_Command *command = c->commands + i;
+        if (command->bind) memcpy(c->bind_base + command->bind - 1, &command->val, sizeof(bool));
+    }
+    for (size_t i = 0; i < c->flag_capacity; ++i) {
+        Argp_Flag *flag = c->flags + i;
+        if (!flag->bind) continue;
+        if (!argp_resolve_flag(flag)) return false;
+        memcpy(c->bind_base + flag->bind - 1, &flag->val, argp_value_size(flag->type));
     }
-    for (size_t i = 0; i < ARGP_POS_CAP; ++i) {
+    for (size_t i = 0; i < c->pos_capacity; ++i) {
         const Argp_Pos *pos = c->poss + i;
-        if (&pos->val == val)
-            return pos->name;
+        if (pos->bind) memcpy(c->bind_base + pos->bind - 1, &pos->val, argp_value_size(pos->type));
     }
-    return NULL;
+    return true;
+}
+#endif  // ARGP_MINIMAL
+
+void argp_free_list(Argp_List *list) { ARGP_FREE(list->items); }
+
+#ifndef ARGP_MINIMAL
+void argp_free_uint_list(Argp_Uint_List *list) { ARGP_FREE(list->items); }
+
+char *argp_map_get(const Argp_Map *map, const char *key) {
+    if (map->size == 0) return NULL;
+    return argp_map_slot(map->items, map->_cap, key)->value;
+}
+
+void argp_free_map(Argp_Map *map) { ARGP_FREE(map->items); }
+
+bool argp_ranges_contains(const Argp_Ranges *ranges, uint64_t v) {
+    size_t lo = 0, hi = ranges->size;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (ranges->items[mid].hi < v)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < ranges->size && ranges->items[lo].lo <= v;
+}
+
+bool argp_ranges_next(Argp_Ranges_Iter *it, uint64_t *v) {
+    const Argp_Ranges *ranges = it->ranges;
+    if (it->_index >= ranges->size) return false;
+
+    if (!it->_started) {
+        it->_next = ranges->items[it->_index].lo;
+        it->_started = true;
+    }
+
+    *v = it->_next;
+    if (it->_next == ranges->items[it->_index].hi) {
+        if (++it->_index < ranges->size)
+            it->_next = ranges->items[it->_index].lo;
+    } else {
+        ++it->_next;
+    }
+    return true;
+}
+
+uint64_t *argp_ranges_bitmap(const Argp_Ranges *ranges, size_t *word_count) {
+    *word_count = 0;
+    if (ranges->size == 0) return NULL;
+
+    uint64_t max = ranges->items[ranges->size - 1].hi;
+    if (max / 64 >= SIZE_MAX / sizeof(uint64_t)) return NULL;
+    size_t words = (size_t)(max / 64) + 1;
+
+    uint64_t *bitmap = (uint64_t *)ARGP_REALLOC(NULL, words * sizeof(uint64_t));
+    if (bitmap == NULL) return NULL;
+    memset(bitmap, 0, words * sizeof(uint64_t));
+
+    for (size_t i = 0; i < ranges->size; ++i) {
+        uint64_t lo = ranges->items[i].lo, hi = ranges->items[i].hi;
+        size_t lo_word = (size_t)(lo / 64), hi_word = (size_t)(hi / 64);
+        uint64_t lo_mask = ~(uint64_t)0 << (lo % 64);
+        uint64_t hi_mask = ~(uint64_t)0 >> (63 - hi % 64);
+
+        if (lo_word == hi_word) {
+            bitmap[lo_word] |= lo_mask & hi_mask;
+            continue;
+        }
+        bitmap[lo_word] |= lo_mask;
+        for (size_t w = lo_word + 1; w < hi_word; ++w) bitmap[w] = ~(uint64_t)0;
+        bitmap[hi_word] |= hi_mask;
+    }
+
+    *word_count = words;
+    return bitmap;
+}
+
+void argp_free_ranges(Argp_Ranges *ranges) { ARGP_FREE(ranges->items); }
+
+size_t argp_sorted_block_count(const Argp_Sorted_List *list) {
+    return (list->count + ARGP_SORTED_BLOCK - 1) / ARGP_SORTED_BLOCK;
+}
+
+static const char *argp_sorted_block(const Argp_Sorted_List *list, size_t block) {
+    size_t block_count = argp_sorted_block_count(list), offset;
+    memcpy(&offset, list->_data + block * sizeof(size_t), sizeof(size_t));
+    return list->_data + block_count * sizeof(size_t) + offset;
+}
+
+void argp_sorted_seek(Argp_Sorted_Iter *it, size_t block) {
+    const Argp_Sorted_List *list = it->list;
+    if (block >= argp_sorted_block_count(list)) {
+        it->_index = list->count;
+        return;
+    }
+    it->_index = block * ARGP_SORTED_BLOCK;
+    it->_at = argp_sorted_block(list, block);
+}
+
+bool argp_sorted_next(Argp_Sorted_Iter *it) {
+    const Argp_Sorted_List *list = it->list;
+    if (it->_index >= list->count) return false;
+    if (it->_index == 0) it->_at = argp_sorted_block(list, 0);
+
+    size_t shared = it->_index % ARGP_SORTED_BLOCK ? argp_read_varint(&it->_at) : 0;
+    size_t n = strlen(it->_at);
+    memcpy(it->buf + shared, it->_at, n + 1);
+    it->_at += n + 1;
+    ++it->_index;
+    return true;
+}
+
+bool argp_sorted_get(const Argp_Sorted_List *list, size_t index, char *buf) {
+    if (index >= list->count) return false;
+    Argp_Sorted_Iter it = ARGP_ZERO(Argp_Sorted_Iter);
+    it.list = list;
+    it.buf = buf;
+    argp_sorted_seek(&it, index / ARGP_SORTED_BLOCK);
+    for (size_t i = 0; i <= index % ARGP_SORTED_BLOCK; ++i) argp_sorted_next(&it);
+    return true;
+}
+
+bool argp_sorted_contains(const Argp_Sorted_List *list, const char *s) {
+    // last block whose first entry is not greater than s
+    size_t lo = 0, hi = argp_sorted_block_count(list);
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (strcmp(argp_sorted_block(list, mid), s) <= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == 0) return false;
+
+    // matched is the length of the prefix the current entry shares with s, which it
+    // precedes: an entry sharing more with the previous one still precedes s, an entry
+    // sharing less follows it
+    size_t block = lo - 1;
+    const unsigned char *p = (const unsigned char *)argp_sorted_block(list, block);
+    const unsigned char *t = (const unsigned char *)s;
+    size_t end = block * ARGP_SORTED_BLOCK + ARGP_SORTED_BLOCK;
+    if (end > list->count) end = list->count;
+
+    size_t matched = 0;
+    for (size_t i = block * ARGP_SORTED_BLOCK; i < end; ++i) {
+        size_t shared = 0;
+        if (i % ARGP_SORTED_BLOCK) shared = argp_read_varint((const char **)&p);
+
+        if (shared == matched) {
+            while (*p && *p == t[matched]) ++p, ++matched;
+            if (*p == t[matched]) return true;
+            if (*p > t[matched]) return false;
+        } else if (shared < matched) {
+            return false;
+        }
+        p += strlen((const char *)p) + 1;
+    }
+    return false;
+}
+
+void argp_free_sorted_list(Argp_Sorted_List *list) { ARGP_FREE(list->_data); }
+#endif  // ARGP_MINIMAL
+
+static const bool *argp_command_handle(const Argp_Command *command) {
+    return command == argp_global_ctx.program_command ? NULL : &command->val;
+}
+
+bool argp_info(const void *val, Argp_Info *info) {
+    Argp_Ctx *c = &argp_global_ctx;
+    size_t i;
+    *info = ARGP_ZERO(Argp_Info);
+
+    if (argp_find_index(val, c->flags, sizeof(Argp_Flag), c->flag_capacity, &i)) {
+        Argp_Flag *flag = c->flags + i;
+#ifndef ARGP_MINIMAL
+        argp_resolve_flag(flag);
+#endif
+        info->kind = ARGP_KIND_FLAG;
+        info->type = flag->type;
+        info->name = flag->long_name ? flag->long_name : flag->short_name;
+#ifndef ARGP_MINIMAL
+        info->desc = flag->desc;
+#endif
+        info->command = argp_command_handle(flag->command);
+        info->def = &flag->def;
+        info->set = flag->source != ARGP_SOURCE_DEFAULT;
+        info->source = flag->source;
+        return true;
+    }
+
+    if (argp_find_index(val, c->poss, sizeof(Argp_Pos), c->pos_capacity, &i)) {
+        const Argp_Pos *pos = c->poss + i;
+        info->kind = ARGP_KIND_POS;
+        info->type = pos->type;
+        info->name = pos->name;
+#ifndef ARGP_MINIMAL
+        info->desc = pos->desc;
+#endif
+        info->command = argp_command_handle(pos->command);
+        info->def = &pos->def;
+        info->set = pos->source != ARGP_SOURCE_DEFAULT;
+        info->source = pos->source;
+        return true;
+    }
+
+    if (argp_find_index(val, c->commands, sizeof(Argp_Command), c->command_capacity, &i)) {
+        const Argp_Command *command = c->commands + i;
+        info->kind = ARGP_KIND_COMMAND;
+        info->type = ARGP_BOOL;
+        info->name = command->name;
+#ifndef ARGP_MINIMAL
+        info->desc = command->desc;
+#endif
+        info->command = command->parent_command ? argp_command_handle(command->parent_command) : NULL;
+        info->set = command->val;
+        info->source = command->val ? ARGP_SOURCE_ARGV : ARGP_SOURCE_DEFAULT;
+        return true;
+    }
+
+    return false;
+}
+
+const char *argp_name(void *val) {
+    Argp_Info info;
+    return argp_info(val, &info) ? info.name : NULL;
+}
+
+#ifndef ARGP_MINIMAL
+bool argp_resolve(const void *val) {
+    Argp_Ctx *c = &argp_global_ctx;
+    size_t i;
+    if (!argp_find_index(val, c->flags, sizeof(Argp_Flag), c->flag_capacity, &i)) return true;
+    return argp_resolve_flag(c->flags + i);
+}
+
+uint64_t argp_get_uint(const uint64_t *val) {
+    argp_resolve(val);
+    return *val;
+}
+
+size_t argp_get_enum(const size_t *val) {
+    argp_resolve(val);
+    return *val;
+}
+
+// hash of everything that determines the layout of the parsed values
+// the program name is skipped, it differs between parent and child processes
+static uint64_t argp_spec_hash(void) {
+    Argp_Ctx *c = &argp_global_ctx;
+    uint64_t h = 0xcbf29ce484222325ull;
+
+    h = argp_hash_u64(h, c->command_capacity);
+    for (size_t i = 0; i < c->command_capacity; ++i) {
+        const Argp_Command *command = c->commands + i;
+        if (command != c->program_command)
+            h = argp_hash_str(h, command->name);
+        h = argp_hash_u64(h, command->parent_command ? (uint64_t)(command->parent_command - c->commands) : UINT64_MAX);
+    }
+
+    h = argp_hash_u64(h, c->flag_capacity);
+    for (size_t i = 0; i < c->flag_capacity; ++i) {
+        const Argp_Flag *flag = c->flags + i;
+        h = argp_hash_u64(h, flag->type);
+        h = argp_hash_str(h, flag->short_name);
+        h = argp_hash_str(h, flag->long_name);
+        h = argp_hash_u64(h, (uint64_t)(flag->command - c->commands));
+        h = argp_hash_u64(h, flag->option_count);
+    }
+
+    h = argp_hash_u64(h, c->pos_capacity);
+    for (size_t i = 0; i < c->pos_capacity; ++i) {
+        const Argp_Pos *pos = c->poss + i;
+        h = argp_hash_u64(h, pos->type);
+        h = argp_hash_str(h, pos->name);
+        h = argp_hash_u64(h, (uint64_t)(pos->command - c->commands));
+        h = argp_hash_u64(h, pos->option_count);
+    }
+
+    return h;
+}
+
+// Snapshot layout, all integers are native endian uint64_t:
+//
+//   magic, spec hash, total size, index of selected command
+//   one word per command: selected
+//   one record per flag: seen, value
+//   one record per positional: seen, value
+//
+// strings are stored inline as length followed by the bytes and a NUL, padded to 8 bytes
+// a NULL string is stored as length UINT64_MAX, lists are stored as count followed by strings
+// maps are stored as count followed by key and value strings, ranges as count followed by pairs
+
+#define ARGP_SNAPSHOT_HEADER_SIZE (4 * sizeof(uint64_t))
+
+static bool argp_snapshot_put_str(Argp_Buf *buf, const char *s) {
+    if (!s) return argp_buf_append_u64(buf, UINT64_MAX);
+
+    static const char pad[8] = {0};
+    size_t n = strlen(s);
+    return argp_buf_append_u64(buf, n) &&
+           argp_buf_append(buf, s, n) &&
+           argp_buf_append(buf, pad, 8 - n % 8);
+}
+
+static bool argp_snapshot_put_value(Argp_Buf *buf, Argp_Type type, const Argp_Value *val) {
+    switch (type) {
+        case ARGP_BOOL:
+            return argp_buf_append_u64(buf, val->as_bool);
+        case ARGP_UINT:
+            return argp_buf_append_u64(buf, val->as_uint);
+        case ARGP_STR:
+            return argp_snapshot_put_str(buf, val->as_str);
+        case ARGP_ENUM:
+            return argp_buf_append_u64(buf, val->as_enum);
+        case ARGP_ENUM_SET:
+            return argp_buf_append_u64(buf, val->as_enum_set);
+        case ARGP_LIST: {
+            if (!argp_buf_append_u64(buf, val->as_list.size)) return false;
+            for (size_t i = 0; i < val->as_list.size; ++i) {
+                if (!argp_snapshot_put_str(buf, val->as_list.items[i])) return false;
+            }
+            return true;
+        }
+        case ARGP_MAP: {
+            if (!argp_buf_append_u64(buf, val->as_map.size)) return false;
+            for (size_t i = 0; i < val->as_map._cap; ++i) {
+                const Argp_Map_Entry *entry = val->as_map.items + i;
+                if (!entry->key) continue;
+                if (!argp_snapshot_put_str(buf, entry->key) ||
+                    !argp_snapshot_put_str(buf, entry->value))
+                    return false;
+            }
+            return true;
+        }
+        case ARGP_RANGES: {
+            if (!argp_buf_append_u64(buf, val->as_ranges.size)) return false;
+            return argp_buf_append(buf, val->as_ranges.items, val->as_ranges.size * sizeof(Argp_Range));
+        }
+        case ARGP_UINT_LIST:
+        case ARGP_ENUM_LIST: {
+            if (!argp_buf_append_u64(buf, val->as_uint_list.size)) return false;
+            return argp_buf_append(buf, val->as_uint_list.items, val->as_uint_list.size * sizeof(uint64_t));
+        }
+        case ARGP_SORTED_LIST: {
+            // stored decoded, entries are front-coded again on load
+            const Argp_Sorted_List *list = &val->as_sorted;
+            if (!argp_buf_append_u64(buf, list->count)) return false;
+            if (list->count == 0) return true;
+
+            char *entry = (char *)ARGP_REALLOC(NULL, list->max_len + 1);
+            if (entry == NULL) return false;
+            bool ok = true;
+            Argp_Sorted_Iter it = ARGP_ZERO(Argp_Sorted_Iter);
+            it.list = list;
+            it.buf = entry;
+            while (ok && argp_sorted_next(&it)) ok = argp_snapshot_put_str(buf, entry);
+            ARGP_FREE(entry);
+            return ok;
+        }
+        default:
+            ARGP_ASSERT(false && "Unreachable");
+    }
+    return false;
+}
+
+static bool argp_dump_str(Argp_Buf *buf, Argp_Dump_Format format, const char *s) {
+    if (format == ARGP_DUMP_TEXT)
+        return argp_buf_printf(buf, "%s", s ? s : "(null)");
+    if (!s)
+        return argp_buf_printf(buf, "null");
+
+    if (!argp_buf_append(buf, "\"", 1)) return false;
+    for (; *s; ++s) {
+        unsigned char ch = (unsigned char)*s;
+        bool ok;
+        if (ch == '"' || ch == '\\')
+            ok = argp_buf_printf(buf, "\\%c", ch);
+        else if (ch < 0x20)
+            ok = argp_buf_printf(buf, "\\u%04x", ch);
+        else
+            ok = argp_buf_append(buf, s, 1);
+        if (!ok) return false;
+    }
+    return argp_buf_append(buf, "\"", 1);
+}
+
+static const char *argp_enum_name(const char **enum_options, size_t option_count, size_t i) {
+    return i < option_count ? enum_options[i] : NULL;
+}
+
+static bool argp_dump_value(Argp_Buf *buf, Argp_Dump_Format format, Argp_Type type,
+                            const Argp_Value *val, const char **enum_options, size_t option_count) {
+    bool json = format == ARGP_DUMP_JSON;
+    switch (type) {
+        case ARGP_BOOL:
+            return argp_buf_printf(buf, "%s", val->as_bool ? "true" : "false");
+        case ARGP_UINT:
+            return argp_buf_printf(buf, "%llu", (unsigned long long)val->as_uint);
+        case ARGP_STR:
+            return argp_dump_str(buf, format, val->as_str);
+        case ARGP_ENUM: {
+            const char *name = argp_enum_name(enum_options, option_count, val->as_enum);
+            if (name) return argp_dump_str(buf, format, name);
+            return argp_buf_printf(buf, "%llu", (unsigned long long)val->as_enum);
+        }
+        case ARGP_ENUM_SET: {
+            bool first = true;
+            if (json && !argp_buf_printf(buf, "[")) return false;
+            for (size_t i = 0; i < option_count && i < 64; ++i) {
+                if (!(val->as_enum_set >> i & 1)) continue;
+                if (!first && !argp_buf_printf(buf, json ? ", " : ",")) return false;
+                if (!argp_dump_str(buf, format, argp_enum_name(enum_options, option_count, i)))
+                    return false;
+                first = false;
+            }
+            return !json || argp_buf_printf(buf, "]");
+        }
+        case ARGP_LIST: {
+            if (json && !argp_buf_printf(buf, "[")) return false;
+            for (size_t i = 0; i < val->as_list.size; ++i) {
+                if (i && !argp_buf_printf(buf, ", ")) return false;
+                if (!argp_dump_str(buf, format, val->as_list.items[i])) return false;
+            }
+            return !json || argp_buf_printf(buf, "]");
+        }
+        case ARGP_MAP: {
+            bool first = true;
+            if (json && !argp_buf_printf(buf, "{")) return false;
+            for (size_t i = 0; i < val->as_map._cap; ++i) {
+                const Argp_Map_Entry *entry = val->as_map.items + i;
+                if (!entry->key) continue;
+                if (!first && !argp_buf_printf(buf, ", ")) return false;
+                if (!argp_dump_str(buf, format, entry->key) ||
+                    !argp_buf_printf(buf, json ? ": " : "=") ||
+                    !argp_dump_str(buf, format, entry->value))
+                    return false;
+                first = false;
+            }
+            return !json || argp_buf_printf(buf, "}");
+        }
+        case ARGP_RANGES: {
+            if (json && !argp_buf_printf(buf, "[")) return false;
+            for (size_t i = 0; i < val->as_ranges.size; ++i) {
+                const Argp_Range *r = val->as_ranges.items + i;
+                bool ok;
+                if (json)
+                    ok = argp_buf_printf(buf, "%s[%llu, %llu]", i ? ", " : "",
+                                         (unsigned long long)r->lo, (unsigned long long)r->hi);
+                else if (r->lo == r->hi)
+                    ok = argp_buf_printf(buf, "%s%llu", i ? "," : "", (unsigned long long)r->lo);
+                else
+                    ok = argp_buf_printf(buf, "%s%llu-%llu", i ? "," : "",
+                                         (unsigned long long)r->lo, (unsigned long long)r->hi);
+                if (!ok) return false;
+            }
+            return !json || argp_buf_printf(buf, "]");
+        }
+        case ARGP_UINT_LIST:
+        case ARGP_ENUM_LIST: {
+            if (json && !argp_buf_printf(buf, "[")) return false;
+            for (size_t i = 0; i < val->as_uint_list.size; ++i) {
+                uint64_t v = val->as_uint_list.items[i];
+                const char *name = type == ARGP_ENUM_LIST
+                                       ? argp_enum_name(enum_options, option_count, (size_t)v)
+                                       : NULL;
+                if (i && !argp_buf_printf(buf, json ? ", " : ",")) return false;
+                if (name ? !argp_dump_str(buf, format, name)
+                         : !argp_buf_printf(buf, "%llu", (unsigned long long)v))
+                    return false;
+            }
+            return !json || argp_buf_printf(buf, "]");
+        }
+        case ARGP_SORTED_LIST: {
+            const Argp_Sorted_List *list = &val->as_sorted;
+            char *entry = list->count ? (char *)ARGP_REALLOC(NULL, list->max_len + 1) : NULL;
+            if (list->count && entry == NULL) return false;
+
+            bool ok = !json || argp_buf_printf(buf, "[");
+            Argp_Sorted_Iter it = ARGP_ZERO(Argp_Sorted_Iter);
+            it.list = list;
+            it.buf = entry;
+            for (size_t i = 0; ok && argp_sorted_next(&it); ++i)
+                ok = (!i || argp_buf_printf(buf, ", ")) && argp_dump_str(buf, format, entry);
+            ARGP_FREE(entry);
+            return ok && (!json || argp_buf_printf(buf, "]"));
+        }
+        default:
+            ARGP_ASSERT(false && "Unreachable");
+    }
+    return false;
+}
+
+static bool argp_dump_entry(Argp_Buf *buf, Argp_Dump_Format format, bool first,
+                            const Argp_Command *command, const char *prefix, const char *name,
+                            Argp_Type type, const Argp_Value *val, Argp_Source source,
+                            const char **enum_options, size_t option_count) {
+    if (format == ARGP_DUMP_TEXT) {
+        int width = 2 + (int)(strlen(prefix) + strlen(name));
+        int n = width < ARGP_PRINT_WIDTH ? ARGP_PRINT_WIDTH - width : 1;
+        return argp_buf_printf(buf, "  %s%s%*s", prefix, name, n, "") &&
+               argp_dump_value(buf, format, type, val, enum_options, option_count) &&
+               argp_buf_printf(buf, "%s\n", source == ARGP_SOURCE_DEFAULT ? " (default)" : "");
+    }
+
+    return argp_buf_printf(buf, "%s\n    {\"command\": ", first ? "" : ",") &&
+           argp_dump_str(buf, format, command->name) &&
+           argp_buf_printf(buf, ", \"name\": ") &&
+           argp_dump_str(buf, format, name) &&
+           argp_buf_printf(buf, ", \"kind\": \"%s\", \"value\": ", *prefix ? "flag" : "positional") &&
+           argp_dump_value(buf, format, type, val, enum_options, option_count) &&
+           argp_buf_printf(buf, ", \"default\": %s}", source == ARGP_SOURCE_DEFAULT ? "true" : "false");
+}
+
+static bool argp_dump_command(Argp_Buf *buf, Argp_Dump_Format format, const Argp_Command *command,
+                              bool *first) {
+    Argp_Ctx *c = &argp_global_ctx;
+
+    if (format == ARGP_DUMP_TEXT && !argp_buf_printf(buf, "%s:\n", command->name))
+        return false;
+
+    for (size_t i = 0; i < c->flag_capacity; ++i) {
+        const Argp_Flag *flag = c->flags + i;
+        if (flag->command != command || flag == command->help_flag) continue;
+
+        const char *prefix = flag->long_name ? "--" : "-";
+        const char *name = flag->long_name ? flag->long_name : flag->short_name;
+        if (!argp_dump_entry(buf, format, *first, command, prefix, name, flag->type, &flag->val,
+                             flag->source, flag->enum_options, flag->option_count))
+            return false;
+        *first = false;
+    }
+
+    for (size_t i = 0; i < c->pos_capacity; ++i) {
+        const Argp_Pos *pos = c->poss + i;
+        if (pos->command != command) continue;
+
+        if (!argp_dump_entry(buf, format, *first, command, "", pos->name, pos->type, &pos->val,
+                             pos->source, pos->enum_options, pos->option_count))
+            return false;
+        *first = false;
+    }
+
+    return true;
+}
+
+ARGP_COLD bool argp_dump(FILE *stream, Argp_Dump_Format format) {
+    Argp_Ctx *c = &argp_global_ctx;
+    Argp_Buf buf = ARGP_ZERO(Argp_Buf);
+    if (!argp_resolve_all()) return false;
+
+    const Argp_Command *path[ARGP_COMMAND_CAP];
+    size_t depth = 0;
+    for (const Argp_Command *command = c->command_ctx ? c->command_ctx : c->program_command;
+         command; command = command->parent_command)
+        path[depth++] = command;
+
+    bool json = format == ARGP_DUMP_JSON;
+    bool ok = argp_buf_printf(&buf, json ? "{\n  \"command\": [" : "command:");
+    for (size_t i = depth; ok && i-- > 0;) {
+        if (json)
+            ok = argp_buf_printf(&buf, i + 1 < depth ? ", " : "") && argp_dump_str(&buf, format, path[i]->name);
+        else
+            ok = argp_buf_printf(&buf, " %s", path[i]->name);
+    }
+    ok = ok && argp_buf_printf(&buf, json ? "],\n  \"arguments\": [" : "\n");
+
+    bool first = true;
+    for (size_t i = depth; ok && i-- > 0;)
+        ok = argp_dump_command(&buf, format, path[i], &first);
+    ok = ok && (!json || argp_buf_printf(&buf, "\n  ]\n}\n"));
+
+    if (!ok) {
+        ARGP_FREE(buf.items);
+        c->err = ARGP_ERROR_ALLOC;
+        return false;
+    }
+
+    // flush what is already buffered, then bypass stdio so the dump reaches the file
+    // in one write(2), stdio would split it at its buffer size
+    ok = fflush(stream) == 0;
+    int fd = fileno(stream);
+    for (size_t off = 0; ok && off < buf.size;) {
+        ssize_t n = write(fd, buf.items + off, buf.size - off);
+        if (n < 0 && errno == EINTR) continue;
+        ok = n > 0;
+        if (ok) off += (size_t)n;
+    }
+    ARGP_FREE(buf.items);
+    return ok;
+}
+
+static bool argp_snapshot_encode(Argp_Buf *buf) {
+    Argp_Ctx *c = &argp_global_ctx;
+    if (!argp_resolve_all()) return false;
+
+    bool ok = argp_buf_append_u64(buf, ARGP_SNAPSHOT_MAGIC) &&
+              argp_buf_append_u64(buf, argp_spec_hash()) &&
+              argp_buf_append_u64(buf, 0) &&
+              argp_buf_append_u64(buf, c->command_ctx ? (uint64_t)(c->command_ctx - c->commands) : 0);
+
+    for (size_t i = 0; ok && i < c->command_capacity; ++i)
+        ok = argp_buf_append_u64(buf, c->commands[i].val);
+
+    for (size_t i = 0; ok && i < c->flag_capacity; ++i) {
+        ok = argp_buf_append_u64(buf, c->flags[i].source != ARGP_SOURCE_DEFAULT) &&
+             argp_snapshot_put_value(buf, c->flags[i].type, &c->flags[i].val);
+    }
+
+    for (size_t i = 0; ok && i < c->pos_capacity; ++i) {
+        ok = argp_buf_append_u64(buf, c->poss[i].source != ARGP_SOURCE_DEFAULT) &&
+             argp_snapshot_put_value(buf, c->poss[i].type, &c->poss[i].val);
+    }
+
+    if (!ok) {
+        ARGP_FREE(buf->items);
+        c->err = ARGP_ERROR_ALLOC;
+        return false;
+    }
+
+    uint64_t size = buf->size;
+    memcpy(buf->items + 2 * sizeof(uint64_t), &size, sizeof(size));
+    return true;
+}
+
+bool argp_snapshot_write(int fd) {
+    Argp_Ctx *c = &argp_global_ctx;
+    Argp_Buf buf = ARGP_ZERO(Argp_Buf);
+    if (!argp_snapshot_encode(&buf)) return false;
+
+    for (size_t off = 0; off < buf.size;) {
+        ssize_t n = write(fd, buf.items + off, buf.size - off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            ARGP_FREE(buf.items);
+            c->err = ARGP_ERROR_SNAPSHOT;
+            return false;
+        }
+        off += (size_t)n;
+    }
+
+    ARGP_FREE(buf.items);
+    return true;
+}
+
+typedef struct {
+    char *data;
+    size_t size;
+    size_t pos;
+} Argp_Reader;
+
+static bool argp_reader_u64(Argp_Reader *r, uint64_t *v) {
+    if (r->size - r->pos < sizeof(*v)) return false;
+    memcpy(v, r->data + r->pos, sizeof(*v));
+    r->pos += sizeof(*v);
+    return true;
+}
+
+static bool argp_reader_str(Argp_Reader *r, char **s) {
+    uint64_t n;
+    if (!argp_reader_u64(r, &n)) return false;
+    if (n == UINT64_MAX) {
+        *s = NULL;
+        return true;
+    }
+
+    if (n >= r->size - r->pos) return false;
+    size_t padded = n + (8 - n % 8);
+    if (padded > r->size - r->pos || r->data[r->pos + n] != '\0') return false;
+
+    *s = r->data + r->pos;
+    r->pos += padded;
+    return true;
+}
+
+// enum values must name one of the options or be the default, a stale or corrupt
+// snapshot could otherwise index past the end of the options
+static bool argp_snapshot_check_enum(Argp_Type type, const Argp_Value *val, const Argp_Value *def,
+                                     size_t option_count) {
+    switch (type) {
+        case ARGP_ENUM:
+            return val->as_enum < option_count || val->as_enum == def->as_enum;
+        case ARGP_ENUM_SET:
+            return option_count >= 64 || (val->as_enum_set >> option_count) == 0 ||
+                   val->as_enum_set == def->as_enum_set;
+        case ARGP_ENUM_LIST:
+            for (size_t i = 0; i < val->as_uint_list.size; ++i) {
+                if (val->as_uint_list.items[i] >= option_count) return false;
+            }
+            return true;
+        default:
+            return true;
+    }
+}
+
+static bool argp_snapshot_get_value(Argp_Reader *r, Argp_Type type, Argp_Value *val) {
+    uint64_t v;
+    switch (type) {
+        case ARGP_BOOL: {
+            if (!argp_reader_u64(r, &v)) return false;
+            val->as_bool = v != 0;
+        } break;
+        case ARGP_UINT: {
+            if (!argp_reader_u64(r, &val->as_uint)) return false;
+        } break;
+        case ARGP_STR: {
+            if (!argp_reader_str(r, &val->as_str)) return false;
+        } break;
+        case ARGP_ENUM: {
+            if (!argp_reader_u64(r, &v)) return false;
+            val->as_enum = (size_t)v;
+        } break;
+        case ARGP_ENUM_SET: {
+            if (!argp_reader_u64(r, &val->as_enum_set)) return false;
+        } break;
+        case ARGP_LIST: {
+            if (!argp_reader_u64(r, &v)) return false;
+            // every entry takes at least one word
+            if (v > (r->size - r->pos) / sizeof(uint64_t)) return false;
+
+            Argp_List list = ARGP_ZERO(Argp_List);
+            if (v) {
+                list.items = (char **)ARGP_REALLOC(NULL, v * sizeof(char *));
+                if (list.items == NULL) return false;
+                list._cap = v;
+            }
+            for (; list.size < v; ++list.size) {
+                if (!argp_reader_str(r, list.items + list.size)) {
+                    ARGP_FREE(list.items);
+                    return false;
+                }
+            }
+            val->as_list = list;
+        } break;
+        case ARGP_MAP: {
+            if (!argp_reader_u64(r, &v)) return false;
+            if (v > (r->size - r->pos) / (2 * sizeof(uint64_t))) return false;
+
+            Argp_Map map = ARGP_ZERO(Argp_Map);
+            for (uint64_t i = 0; i < v; ++i) {
+                char *key, *value;
+                if (!argp_reader_str(r, &key) || !argp_reader_str(r, &value) || !key ||
+                    argp_map_insert(&map, key, value, false) != ARGP_MAP_INSERTED) {
+                    ARGP_FREE(map.items);
+                    return false;
+                }
+            }
+            val->as_map = map;
+        } break;
+        case ARGP_RANGES: {
+            if (!argp_reader_u64(r, &v)) return false;
+            if (v > (r->size - r->pos) / sizeof(Argp_Range)) return false;
+
+            Argp_Ranges ranges = ARGP_ZERO(Argp_Ranges);
+            if (v) {
+                ranges.items = (Argp_Range *)ARGP_REALLOC(NULL, v * sizeof(Argp_Range));
+                if (ranges.items == NULL) return false;
+                memcpy(ranges.items, r->data + r->pos, v * sizeof(Argp_Range));
+                ranges.size = ranges._cap = v;
+                r->pos += v * sizeof(Argp_Range);
+            }
+            val->as_ranges = ranges;
+        } break;
+        case ARGP_UINT_LIST:
+        case ARGP_ENUM_LIST: {
+            if (!argp_reader_u64(r, &v)) return false;
+            if (v > (r->size - r->pos) / sizeof(uint64_t)) return false;
+
+            Argp_Uint_List list = ARGP_ZERO(Argp_Uint_List);
+            if (v) {
+                list.items = (uint64_t *)ARGP_REALLOC(NULL, v * sizeof(uint64_t));
+                if (list.items == NULL) return false;
+                memcpy(list.items, r->data + r->pos, v * sizeof(uint64_t));
+                list.size = list._cap = v;
+                r->pos += v * sizeof(uint64_t);
+            }
+            val->as_uint_list = list;
+        } break;
+        case ARGP_SORTED_LIST: {
+            if (!argp_reader_u64(r, &v)) return false;
+            if (v > (r->size - r->pos) / sizeof(uint64_t)) return false;
+
+            char **items = v ? (char **)ARGP_REALLOC(NULL, v * sizeof(char *)) : NULL;
+            if (v && items == NULL) return false;
+            bool ok = true;
+            for (uint64_t i = 0; ok && i < v; ++i) {
+                ok = argp_reader_str(r, items + i) && items[i] &&
+                     (i == 0 || strcmp(items[i - 1], items[i]) < 0);
+            }
+            val->as_sorted = ARGP_ZERO(Argp_Sorted_List);
+            ok = ok && argp_sorted_encode(items, (size_t)v, &val->as_sorted);
+            ARGP_FREE(items);
+            if (!ok) return false;
+        } break;
+        default:
+            ARGP_ASSERT(false && "Unreachable");
+    }
+    return true;
+}
+
+// frees what a decoded value owns
+static void argp_free_value(Argp_Type type, Argp_Value *val) {
+    switch (type) {
+        case ARGP_LIST: argp_free_list(&val->as_list); break;
+        case ARGP_MAP: argp_free_map(&val->as_map); break;
+        case ARGP_RANGES: argp_free_ranges(&val->as_ranges); break;
+        case ARGP_UINT_LIST:
+        case ARGP_ENUM_LIST: argp_free_uint_list(&val->as_uint_list); break;
+        case ARGP_SORTED_LIST: argp_free_sorted_list(&val->as_sorted); break;
+        default: break;
+    }
+}
+
+static bool argp_read_all(int fd, char *data, size_t size) {
+    for (size_t off = 0; off < size;) {
+        ssize_t n = read(fd, data + off, size - off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        off += (size_t)n;
+    }
+    return true;
+}
+
+// decodes the values following the header, on failure nothing is left allocated
+static bool argp_snapshot_decode(Argp_Reader *r, bool *command_vals, Argp_Value *flag_vals, bool *flag_seen,
+                                 Argp_Value *pos_vals, bool *pos_seen) {
+    Argp_Ctx *c = &argp_global_ctx;
+    size_t flags_read = 0, poss_read = 0;
+
+    bool ok = true;
+    uint64_t v = 0;
+    for (size_t i = 0; ok && i < c->command_capacity; ++i) {
+        ok = argp_reader_u64(r, &v);
+        command_vals[i] = v != 0;
+    }
+    for (; ok && flags_read < c->flag_capacity; ++flags_read) {
+        flag_vals[flags_read] = ARGP_ZERO(Argp_Value);
+        const Argp_Flag *flag = c->flags + flags_read;
+        ok = argp_reader_u64(r, &v) && argp_snapshot_get_value(r, flag->type, flag_vals + flags_read);
+        flag_seen[flags_read] = v != 0;
+        if (ok && !argp_snapshot_check_enum(flag->type, flag_vals + flags_read, &flag->def, flag->option_count)) {
+            argp_free_value(flag->type, flag_vals + flags_read);
+            ok = false;
+        }
+    }
+    for (; ok && poss_read < c->pos_capacity; ++poss_read) {
+        pos_vals[poss_read] = ARGP_ZERO(Argp_Value);
+        const Argp_Pos *pos = c->poss + poss_read;
+        ok = argp_reader_u64(r, &v) && argp_snapshot_get_value(r, pos->type, pos_vals + poss_read);
+        pos_seen[poss_read] = v != 0;
+        if (ok && !argp_snapshot_check_enum(pos->type, pos_vals + poss_read, &pos->def, pos->option_count)) {
+            argp_free_value(pos->type, pos_vals + poss_read);
+            ok = false;
+        }
+    }
+
+    if (!ok || r->pos != r->size) {
+        for (size_t i = 0; i < flags_read; ++i)
+            argp_free_value(c->flags[i].type, flag_vals + i);
+        for (size_t i = 0; i < poss_read; ++i)
+            argp_free_value(c->poss[i].type, pos_vals + i);
+        return false;
+    }
+    return true;
+}
+
+bool argp_snapshot_load(int fd) {
+    Argp_Ctx *c = &argp_global_ctx;
+    c->err = ARGP_ERROR_SNAPSHOT;
+
+    uint64_t header[ARGP_SNAPSHOT_HEADER_SIZE / sizeof(uint64_t)];
+    if (!argp_read_all(fd, (char *)header, sizeof(header))) return false;
+
+    uint64_t magic = header[0], hash = header[1], size = header[2], command_index = header[3];
+    if (magic != ARGP_SNAPSHOT_MAGIC || hash != argp_spec_hash()) return false;
+    if (size < sizeof(header) || (size_t)size != size || command_index >= c->command_capacity) return false;
+
+    char *data = (char *)ARGP_REALLOC(NULL, (size_t)size);
+    if (data == NULL) {
+        c->err = ARGP_ERROR_ALLOC;
+        return false;
+    }
+    memcpy(data, header, sizeof(header));
+    if (!argp_read_all(fd, data + sizeof(header), (size_t)size - sizeof(header))) {
+        ARGP_FREE(data);
+        return false;
+    }
+
+    Argp_Reader r = {data, (size_t)size, sizeof(header)};
+
+    // decode into scratch values so a corrupt snapshot leaves the parsed values untouched
+    Argp_Value flag_vals[ARGP_FLAG_CAP];
+    Argp_Value pos_vals[ARGP_POS_CAP];
+    bool command_vals[ARGP_COMMAND_CAP];
+    bool flag_seen[ARGP_FLAG_CAP];
+    bool pos_seen[ARGP_POS_CAP];
+
+    if (!argp_snapshot_decode(&r, command_vals, flag_vals, flag_seen, pos_vals, pos_seen)) {
+        ARGP_FREE(data);
+        return false;
+    }
+
+    // the values being replaced can't be reached by the caller anymore
+    for (size_t i = 0; i < c->command_capacity; ++i)
+        c->commands[i].val = command_vals[i];
+    for (size_t i = 0; i < c->flag_capacity; ++i) {
+        Argp_Flag *flag = c->flags + i;
+        argp_free_value(flag->type, &flag->val);
+        flag->val = flag_vals[i];
+        flag->raw = NULL;
+        flag->source = flag_seen[i] ? ARGP_SOURCE_SNAPSHOT : ARGP_SOURCE_DEFAULT;
+    }
+    for (size_t i = 0; i < c->pos_capacity; ++i) {
+        Argp_Pos *pos = c->poss + i;
+        argp_free_value(pos->type, &pos->val);
+        pos->val = pos_vals[i];
+        pos->source = pos_seen[i] ? ARGP_SOURCE_SNAPSHOT : ARGP_SOURCE_DEFAULT;
+    }
+
+    c->command_ctx = c->commands + command_index;
+    ARGP_FREE(c->snapshot);
+    c->snapshot = data;
+    c->err = ARGP_NO_ERROR;
+    return true;
+}
+
+struct Argp_Generation {
+    bool commands[ARGP_COMMAND_CAP];
+    Argp_Value flags[ARGP_FLAG_CAP];
+    Argp_Value poss[ARGP_POS_CAP];
+    char *data;  // strings point into it
+
+    uint64_t retired_epoch;
+    Argp_Generation *next;
+};
+
+static void argp_free_generation(Argp_Generation *gen) {
+    Argp_Ctx *c = &argp_global_ctx;
+    for (size_t i = 0; i < c->flag_capacity; ++i)
+        argp_free_value(c->flags[i].type, gen->flags + i);
+    for (size_t i = 0; i < c->pos_capacity; ++i)
+        argp_free_value(c->poss[i].type, gen->poss + i);
+    ARGP_FREE(gen->data);
+    ARGP_FREE(gen);
+}
+
+bool argp_publish(void) {
+    Argp_Ctx *c = &argp_global_ctx;
+
+    // deep copy through the snapshot encoding so the generation owns every string
+    Argp_Buf buf = ARGP_ZERO(Argp_Buf);
+    if (!argp_snapshot_encode(&buf)) return false;
+
+    Argp_Generation *gen = (Argp_Generation *)ARGP_REALLOC(NULL, sizeof(Argp_Generation));
+    if (gen == NULL) {
+        ARGP_FREE(buf.items);
+        c->err = ARGP_ERROR_ALLOC;
+        return false;
+    }
+
+    bool flag_seen[ARGP_FLAG_CAP];
+    bool pos_seen[ARGP_POS_CAP];
+    Argp_Reader r = {buf.items, buf.size, ARGP_SNAPSHOT_HEADER_SIZE};
+    if (!argp_snapshot_decode(&r, gen->commands, gen->flags, flag_seen, gen->poss, pos_seen)) {
+        ARGP_FREE(buf.items);
+        ARGP_FREE(gen);
+        c->err = ARGP_ERROR_ALLOC;
+        return false;
+    }
+    gen->data = buf.items;
+    gen->next = NULL;
+
+    Argp_Generation *old = __atomic_exchange_n(&c->generation, gen, __ATOMIC_SEQ_CST);
+    if (old) {
+        // readers that have seen this epoch can only load the new generation
+        old->retired_epoch = __atomic_add_fetch(&c->epoch, 1, __ATOMIC_SEQ_CST);
+        old->next = c->retired;
+        c->retired = old;
+    }
+
+    argp_rcu_reclaim();
+    return true;
+}
+
+static void argp_reset_values(void) {
+    Argp_Ctx *c = &argp_global_ctx;
+
+    for (size_t i = 0; i < c->command_capacity; ++i) {
+        c->commands[i].val = false;
+        c->commands[i].cur_pos = 0;
+    }
+    for (size_t i = 0; i < c->flag_capacity; ++i) {
+        Argp_Flag *flag = c->flags + i;
+        flag->val = flag->def;
+        flag->raw = NULL;
+        flag->raw_list.size = 0;
+        flag->source = ARGP_SOURCE_DEFAULT;
+    }
+    for (size_t i = 0; i < c->pos_capacity; ++i) {
+        Argp_Pos *pos = c->poss + i;
+        pos->val = pos->def;
+        pos->raw.size = 0;
+        pos->source = ARGP_SOURCE_DEFAULT;
+    }
+    argp_free_ingested();
+
+    c->err = ARGP_NO_ERROR;
+    c->err_flag = NULL;
+    c->err_pos = NULL;
+    c->unknown_option = NULL;
+    c->err_index = 0;
+    c->command_ctx = NULL;
+}
+
+// values of the last good parse, kept until a reload replaces them
+typedef struct {
+    bool commands[ARGP_COMMAND_CAP];
+    Argp_Value flags[ARGP_FLAG_CAP];
+    char *flag_raws[ARGP_FLAG_CAP];
+    Argp_Source flag_sources[ARGP_FLAG_CAP];
+    Argp_Value poss[ARGP_POS_CAP];
+    Argp_Source pos_sources[ARGP_POS_CAP];
+} Argp_Saved_Values;
+
+static void argp_save_values(Argp_Saved_Values *saved) {
+    Argp_Ctx *c = &argp_global_ctx;
+    for (size_t i = 0; i < c->command_capacity; ++i) saved->commands[i] = c->commands[i].val;
+    for (size_t i = 0; i < c->flag_capacity; ++i) {
+        saved->flags[i] = c->flags[i].val;
+        saved->flag_raws[i] = c->flags[i].raw;
+        saved->flag_sources[i] = c->flags[i].source;
+    }
+    for (size_t i = 0; i < c->pos_capacity; ++i) {
+        saved->poss[i] = c->poss[i].val;
+        saved->pos_sources[i] = c->poss[i].source;
+    }
+}
+
+static void argp_restore_values(const Argp_Saved_Values *saved) {
+    Argp_Ctx *c = &argp_global_ctx;
+    for (size_t i = 0; i < c->command_capacity; ++i) c->commands[i].val = saved->commands[i];
+    for (size_t i = 0; i < c->flag_capacity; ++i) {
+        argp_free_value(c->flags[i].type, &c->flags[i].val);
+        c->flags[i].val = saved->flags[i];
+        c->flags[i].raw = saved->flag_raws[i];
+        c->flags[i].source = saved->flag_sources[i];
+    }
+    for (size_t i = 0; i < c->pos_capacity; ++i) {
+        argp_free_value(c->poss[i].type, &c->poss[i].val);
+        c->poss[i].val = saved->poss[i];
+        c->poss[i].source = saved->pos_sources[i];
+    }
+}
+
+bool argp_reload(int argc, char **argv) {
+    Argp_Ctx *c = &argp_global_ctx;
+    c->owns_values = true;
+
+    // structs bound with argp_bind borrow the current values, so they are only freed
+    // once the new ones are bound
+    Argp_Saved_Values *saved = (Argp_Saved_Values *)ARGP_REALLOC(NULL, sizeof(Argp_Saved_Values));
+    if (saved == NULL) {
+        c->err = ARGP_ERROR_ALLOC;
+        return false;
+    }
+    argp_save_values(saved);
+
+    argp_reset_values();
+    c->rest_argc = argc;
+    c->rest_argv = argv;
+    bool ok = argp_parse_args() && argp_publish();
+
+    if (ok) {
+        for (size_t i = 0; i < c->flag_capacity; ++i) argp_free_value(c->flags[i].type, saved->flags + i);
+        for (size_t i = 0; i < c->pos_capacity; ++i) argp_free_value(c->poss[i].type, saved->poss + i);
+    } else {
+        Argp_Error err = c->err;
+        argp_restore_values(saved);
+        argp_bind(c->bind_base);
+        c->err = err;
+    }
+    ARGP_FREE(saved);
+    return ok;
+}
+
+bool argp_reload_file(const char *path) {
+    Argp_Ctx *c = &argp_global_ctx;
+
+    int flags = O_RDONLY;
+#ifdef O_CLOEXEC
+    flags |= O_CLOEXEC;
+#endif
+    int fd = open(path, flags);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        c->err = argp_path_error(errno);
+        c->err_flag = NULL;
+        c->err_pos = NULL;
+        c->unknown_option = path;
+        if (fd >= 0) close(fd);
+        return false;
+    }
+
+    size_t size = (size_t)st.st_size;
+    char *data = (char *)ARGP_REALLOC(NULL, size + 1);
+    if (data == NULL) {
+        close(fd);
+        c->err = ARGP_ERROR_ALLOC;
+        return false;
+    }
+    bool ok = argp_read_all(fd, data, size);
+    close(fd);
+    if (!ok) {
+        ARGP_FREE(data);
+        c->err = ARGP_ERROR_PATH_NOT_READABLE;
+        c->err_flag = NULL;
+        c->err_pos = NULL;
+        c->unknown_option = path;
+        return false;
+    }
+    data[size] = '\0';
+
+    // split in place, every token takes at least two bytes
+    char **argv = (char **)ARGP_REALLOC(NULL, (size / 2 + 3) * sizeof(char *));
+    if (argv == NULL) {
+        ARGP_FREE(data);
+        c->err = ARGP_ERROR_ALLOC;
+        return false;
+    }
+
+    int argc = 0;
+    argv[argc++] = (char *)c->program_command->name;
+    for (char *p = data; *p;) {
+        if (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
+            ++p;
+        } else if (*p == '#') {
+            while (*p && *p != '\n') ++p;
+        } else {
+            argv[argc++] = p;
+            while (*p && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') ++p;
+            if (*p) *p++ = '\0';
+        }
+    }
+    argv[argc] = NULL;
+
+    ok = argp_reload(argc, argv);
+
+    // the values point into the file of the last good reload, the error into this one
+    ARGP_FREE(c->reload_failed_data);
+    ARGP_FREE(c->reload_failed_argv);
+    c->reload_failed_data = NULL;
+    c->reload_failed_argv = NULL;
+    if (ok) {
+        ARGP_FREE(c->reload_data);
+        ARGP_FREE(c->reload_argv);
+        c->reload_data = data;
+        c->reload_argv = argv;
+    } else {
+        c->reload_failed_data = data;
+        c->reload_failed_argv = argv;
+    }
+    return ok;
+}
+
+const Argp_Generation *argp_current(void) {
+    return __atomic_load_n(&argp_global_ctx.generation, __ATOMIC_ACQUIRE);
+}
+
+const void *argp_get(const Argp_Generation *gen, const void *handle) {
+    Argp_Ctx *c = &argp_global_ctx;
+    size_t i;
+
+    if (argp_find_index(handle, c->flags, sizeof(Argp_Flag), c->flag_capacity, &i))
+        return gen->flags + i;
+    if (argp_find_index(handle, c->poss, sizeof(Argp_Pos), c->pos_capacity, &i))
+        return gen->poss + i;
+    if (argp_find_index(handle, c->commands, sizeof(Argp_Command), c->command_capacity, &i))
+        return gen->commands + i;
+    return NULL;
+}
+
+bool argp_rcu_register(Argp_Rcu_Reader *reader) {
+    Argp_Ctx *c = &argp_global_ctx;
+    argp_rcu_quiescent(reader);
+
+    for (size_t i = 0; i < ARGP_RCU_READER_CAP; ++i) {
+        Argp_Rcu_Reader *expected = NULL;
+        if (__atomic_compare_exchange_n(c->readers + i, &expected, reader, false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+            return true;
+    }
+    return false;
+}
+
+void argp_rcu_unregister(Argp_Rcu_Reader *reader) {
+    Argp_Ctx *c = &argp_global_ctx;
+    for (size_t i = 0; i < ARGP_RCU_READER_CAP; ++i) {
+        Argp_Rcu_Reader *expected = reader;
+        if (__atomic_compare_exchange_n(c->readers + i, &expected, NULL, false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+            return;
+    }
+}
+
+void argp_rcu_quiescent(Argp_Rcu_Reader *reader) {
+    uint64_t epoch = __atomic_load_n(&argp_global_ctx.epoch, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&reader->_epoch, epoch, __ATOMIC_RELEASE);
+}
+
+void argp_rcu_reclaim(void) {
+    Argp_Ctx *c = &argp_global_ctx;
+
+    uint64_t min = __atomic_load_n(&c->epoch, __ATOMIC_SEQ_CST);
+    for (size_t i = 0; i < ARGP_RCU_READER_CAP; ++i) {
+        Argp_Rcu_Reader *reader = __atomic_load_n(c->readers + i, __ATOMIC_SEQ_CST);
+        if (reader == NULL) continue;
+        uint64_t epoch = __atomic_load_n(&reader->_epoch, __ATOMIC_ACQUIRE);
+        if (epoch < min) min = epoch;
+    }
+
+    for (Argp_Generation **link = &c->retired; *link;) {
+        Argp_Generation *gen = *link;
+        if (gen->retired_epoch <= min) {
+            *link = gen->next;
+            argp_free_generation(gen);
+        } else {
+            link = &gen->next;
+        }
+    }
+}
+
+#ifdef __linux__
+// points to the last component of path
+static const char *argp_basename(const char *path) {
+    const char *slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+int argp_reload_watch(const char *path) {
+    const char *base = argp_basename(path);
+    size_t n = (size_t)(base - path);
+
+    char dir[ARGP_PATH_MAX];
+    if (n >= sizeof(dir)) return -1;
+    if (n == 0) {
+        dir[0] = '.';
+        dir[1] = '\0';
+    } else {
+        memcpy(dir, path, n);
+        dir[n] = '\0';
+    }
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) return -1;
+    if (inotify_add_watch(fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool argp_reload_watch_handle(int fd, const char *path) {
+    const char *base = argp_basename(path);
+    bool changed = false;
+
+    union {
+        struct inotify_event event;
+        char bytes[4096];
+    } buf;
+
+    for (;;) {
+        ssize_t n = read(fd, buf.bytes, sizeof(buf.bytes));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+
+        for (char *p = buf.bytes; p < buf.bytes + n;) {
+            const struct inotify_event *event = (const struct inotify_event *)p;
+            if (event->len && strcmp(event->name, base) == 0) changed = true;
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    return !changed || argp_reload_file(path);
+}
+#endif
+#endif  // ARGP_MINIMAL
+
+// frees what the context owns, values are freed only if they belong to the library
+static void argp_release(void) {
+    Argp_Ctx *c = &argp_global_ctx;
+    ARGP_FREE(c->pos_tokens);
+    ARGP_FREE(c->names.items);
+
+#ifndef ARGP_MINIMAL
+    if (c->owns_values) {
+        for (size_t i = 0; i < c->flag_capacity; ++i) argp_free_value(c->flags[i].type, &c->flags[i].val);
+        for (size_t i = 0; i < c->pos_capacity; ++i) argp_free_value(c->poss[i].type, &c->poss[i].val);
+    }
+    if (c->generation) argp_free_generation(c->generation);
+    while (c->retired) {
+        Argp_Generation *next = c->retired->next;
+        argp_free_generation(c->retired);
+        c->retired = next;
+    }
+
+    argp_free_pending();
+    ARGP_FREE(c->ingested.items);
+    ARGP_FREE(c->range_entries);
+    ARGP_FREE(c->snapshot);
+    ARGP_FREE(c->search.text);
+    ARGP_FREE(c->search.words);
+    ARGP_FREE(c->reload_data);
+    ARGP_FREE(c->reload_argv);
+    ARGP_FREE(c->reload_failed_data);
+    ARGP_FREE(c->reload_failed_argv);
+#endif
 }
 
 #endif  // ARGPARSE_IMPLEMENTATION
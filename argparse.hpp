@@ -0,0 +1,442 @@
+// argparse.hpp -- typed C++17 layer over argparse.h
+//
+//    The spec is a constexpr list of flags and positional arguments. Option names are
+//    checked for duplicates at compile time, including the reserved -h, --help and
+//    --help-search. get finds the index of its handle while compiling, so values are read
+//    back without any runtime name lookup. Command line tokens are matched by the hash
+//    table of the C library.
+//
+//    bool, uint64_t, std::string_view and argp::list are parsed by the C library, which
+//    converts numbers with std::from_chars when compiled as C++17. Any other arithmetic type
+//    is parsed from the argument string with std::from_chars here. Lists are returned as
+//    std::span when compiled as C++20.
+//
+// Usage:
+//
+//    #define ARGPARSE_IMPLEMENTATION
+//    #include "argparse.hpp"
+//
+//    inline constexpr argp::flag<uint64_t> retries{"r", "retries", 3, "number of retries", "N"};
+//    inline constexpr argp::flag<double> ratio{nullptr, "ratio", 0.5, "compression ratio"};
+//    inline constexpr argp::pos<argp::list> files{"files", {}, "input files"};
+//    inline constexpr auto spec = argp::make_spec(retries, ratio, files);
+//
+//    int main(int argc, char **argv) {
+//        argp::parser<spec> args(argc, argv, "program description");
+//        if (!args.parse()) {
+//            args.print_error(stderr);
+//            return 1;
+//        }
+//        uint64_t r = args.get<retries>();
+//        double x = args.get<ratio>();
+//        for (char *file : args.get<files>()) ...
+//    }
+//
+// With .bind = ARGP_BIND(Config, member), parse(cfg) binds cfg with argp_bind, so cfg.member is
+// written by every parse and reload. The member has the type the C library stores: bool,
+// uint64_t, char * for std::string_view, NULL if the argument was not given, and Argp_List for
+// argp::list. Other types are converted here and cannot be bound.
+//
+// Commands are not part of the spec, register them and their arguments through the C API
+// between constructing the parser and calling parse.
+#ifndef ARGPARSE_HPP
+#define ARGPARSE_HPP
+
+#include "argparse.h"
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if __cplusplus >= 202002L
+#include <span>
+#endif
+
+namespace argp {
+
+// marks a flag or positional argument that collects every value into a list
+struct list {};
+
+#if __cplusplus >= 202002L
+using list_view = std::span<char *const>;
+#else
+struct list_view {
+    char *const *first = nullptr;
+    std::size_t count = 0;
+
+    constexpr char *const *begin() const { return first; }
+    constexpr char *const *end() const { return first + count; }
+    constexpr std::size_t size() const { return count; }
+    constexpr bool empty() const { return count == 0; }
+    constexpr char *operator[](std::size_t i) const { return first[i]; }
+};
+#endif
+
+template <typename T>
+struct flag {
+    using value_type = T;
+
+    const char *short_name = nullptr;
+    const char *long_name = nullptr;
+    T def{};
+    const char *desc = nullptr;
+    const char *meta_var = nullptr;
+    std::size_t bind = 0;  // ARGP_BIND(Config, member)
+};
+
+template <typename T>
+struct pos {
+    using value_type = T;
+
+    const char *name = nullptr;
+    T def{};
+    const char *desc = nullptr;
+    Argp_Required req = ARGP_OPTIONAL;
+    std::size_t bind = 0;  // ARGP_BIND(Config, member)
+};
+
+namespace detail {
+
+template <typename T>
+struct is_flag : std::false_type {};
+template <typename T>
+struct is_flag<flag<T>> : std::true_type {};
+
+template <typename T>
+struct is_pos : std::false_type {};
+template <typename T>
+struct is_pos<pos<T>> : std::true_type {};
+
+// types converted by the C library, everything else goes through std::from_chars
+template <typename T>
+inline constexpr bool is_native =
+    std::is_same_v<T, bool> || std::is_same_v<T, uint64_t> ||
+    std::is_same_v<T, std::string_view> || std::is_same_v<T, list>;
+
+template <typename T>
+inline constexpr bool is_supported = is_native<T> || std::is_arithmetic_v<T>;
+
+// what the parser keeps for each argument: the pointer returned by the C library and,
+// for converted types, the converted value
+template <typename T, bool Native = is_native<T>>
+struct slot;
+
+template <typename T>
+struct slot<T, true> {
+    void *handle = nullptr;
+};
+
+template <typename T>
+struct slot<T, false> {
+    void *handle = nullptr;
+    T value{};
+};
+
+// option names live in one namespace per kind, -v and --v do not collide
+struct key {
+    char kind = 0;  // 's' short flag name, 'l' long flag name, 'p' positional name
+    std::string_view name;
+
+    constexpr bool operator==(const key &other) const {
+        return kind == other.kind && name == other.name;
+    }
+};
+
+// appends the names of an argument, values get the index of the argument in the spec
+template <typename T>
+constexpr std::size_t add_keys(const flag<T> &f, std::size_t index, key *keys, std::size_t *values) {
+    if (!f.short_name && !f.long_name) throw std::logic_error("argp: flag without a name");
+    std::size_t n = 0;
+    if (f.short_name) {
+        keys[n] = key{'s', f.short_name};
+        values[n++] = index;
+    }
+    if (f.long_name) {
+        keys[n] = key{'l', f.long_name};
+        values[n++] = index;
+    }
+    return n;
+}
+
+template <typename T>
+constexpr std::size_t add_keys(const pos<T> &p, std::size_t index, key *keys, std::size_t *values) {
+    if (!p.name) throw std::logic_error("argp: positional argument without a name");
+    keys[0] = key{'p', p.name};
+    values[0] = index;
+    return 1;
+}
+
+template <typename T>
+constexpr key handle_key(const flag<T> &f) {
+    return f.long_name ? key{'l', f.long_name} : key{'s', f.short_name};
+}
+
+template <typename T>
+constexpr key handle_key(const pos<T> &p) {
+    return key{'p', p.name};
+}
+
+// parses the whole string, returns ARGP_NO_ERROR or the error the C library would report
+template <typename T>
+Argp_Error convert(const char *arg, T &out) {
+    std::string_view s(arg);
+    T v{};
+    auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), v);
+    if (ec == std::errc::result_out_of_range) return ARGP_ERROR_INTEGER_OVERFLOW;
+    if (ec != std::errc() || end != s.data() + s.size()) return ARGP_ERROR_INVALID_NUMBER;
+    out = v;
+    return ARGP_NO_ERROR;
+}
+
+}  // namespace detail
+
+template <typename... Args>
+class spec {
+    static_assert(((detail::is_flag<Args>::value || detail::is_pos<Args>::value) && ...),
+                  "argp::spec holds only argp::flag and argp::pos");
+    static_assert((detail::is_supported<typename Args::value_type> && ...),
+                  "unsupported argument type");
+
+   public:
+    static constexpr std::size_t size = sizeof...(Args);
+
+    std::tuple<Args...> args;
+
+    constexpr explicit spec(const Args &...a) : args(a...), names(build(a...)) {}
+
+    // index of the argument with the given names, fails to compile if there is none
+    template <typename T>
+    constexpr std::size_t index_of(const T &handle) const {
+        detail::key k = detail::handle_key(handle);
+        for (std::size_t i = reserved_count; i < names.count; ++i) {
+            if (names.keys[i] == k) return names.values[i];
+        }
+        throw std::logic_error("argp: argument is not part of the spec");
+    }
+
+   private:
+    // names the C library registers itself, a spec reusing one fails as a duplicate
+    static constexpr detail::key reserved[] = {{'s', "h"}, {'l', "help"}, {'l', "help-search"}};
+    static constexpr std::size_t reserved_count = sizeof reserved / sizeof reserved[0];
+
+    static constexpr std::size_t key_total =
+        (reserved_count + ... + (detail::is_flag<Args>::value ? 2 : 1));
+
+    struct table {
+        std::array<detail::key, key_total> keys{};
+        std::array<std::size_t, key_total> values{};
+        std::size_t count = 0;
+    };
+
+    // a spec has a few dozen names at most, comparing every pair costs nothing at run time
+    static constexpr table build(const Args &...a) {
+        table t{};
+        std::size_t index = 0;
+        for (const detail::key &k : reserved) t.keys[t.count++] = k;
+        ((t.count += detail::add_keys(a, index++, t.keys.data() + t.count, t.values.data() + t.count)), ...);
+
+        for (std::size_t i = 0; i < t.count; ++i) {
+            for (std::size_t j = 0; j < i; ++j) {
+                if (t.keys[i] == t.keys[j]) throw std::logic_error("argp: duplicate argument name");
+            }
+        }
+        return t;
+    }
+
+    table names;
+};
+
+template <typename... Args>
+constexpr spec<Args...> make_spec(const Args &...args) {
+    return spec<Args...>(args...);
+}
+
+template <const auto &Spec>
+class parser {
+    using spec_type = std::remove_cv_t<std::remove_reference_t<decltype(Spec)>>;
+
+    template <std::size_t I>
+    using arg_type = std::tuple_element_t<I, decltype(spec_type::args)>;
+
+    template <std::size_t I>
+    using value_type = typename arg_type<I>::value_type;
+
+   public:
+    parser(int argc, char **argv, const char *desc = nullptr) {
+        Argp_Opt opt{};
+        opt.desc = desc;
+        opt.help = true;
+        argp_init_(argc, argv, opt);
+        register_all(std::make_index_sequence<spec_type::size>{});
+    }
+
+    bool parse() {
+        if (!argp_parse_args()) return false;
+        return convert_all(std::make_index_sequence<spec_type::size>{});
+    }
+
+#ifndef ARGP_MINIMAL
+    // binds cfg with argp_bind and parses, cfg then follows every later reload as well
+    template <typename Config>
+    bool parse(Config &cfg) {
+        static_assert(std::is_standard_layout_v<Config>, "ARGP_BIND needs a standard layout struct");
+        argp_bind(&cfg);
+        return parse();
+    }
+#endif
+
+    template <const auto &Handle>
+    auto get() const {
+        constexpr std::size_t I = Spec.index_of(Handle);
+        static_assert(std::is_same_v<std::remove_cv_t<std::remove_reference_t<decltype(Handle)>>,
+                                     arg_type<I>>,
+                      "handle type does not match the spec");
+        return at<I>();
+    }
+
+    // value of the I-th argument of the spec
+    template <std::size_t I>
+    auto at() const {
+        using T = value_type<I>;
+        const auto &s = std::get<I>(slots);
+        const auto &arg = std::get<I>(Spec.args);
+
+        if constexpr (std::is_same_v<T, bool>) {
+            return *static_cast<const bool *>(s.handle);
+        } else if constexpr (std::is_same_v<T, uint64_t>) {
+            return *static_cast<const uint64_t *>(s.handle);
+        } else if constexpr (std::is_same_v<T, std::string_view>) {
+            const char *str = *static_cast<char *const *>(s.handle);
+            return str ? std::string_view(str) : arg.def;
+        } else if constexpr (std::is_same_v<T, list>) {
+            const Argp_List *l = static_cast<const Argp_List *>(s.handle);
+            return list_view{l->items, l->size};
+        } else {
+            return s.value;
+        }
+    }
+
+#ifndef ARGP_MINIMAL
+    void print_error(FILE *stream) const {
+        if (err == ARGP_NO_ERROR) {
+            argp_print_error(stream);
+            return;
+        }
+
+        fprintf(stream, "Error: %s", err == ARGP_ERROR_INTEGER_OVERFLOW ? "Integer overflow" : "Invalid number");
+        if (err_long_name)
+            fprintf(stream, " for flag --%s", err_long_name);
+        else if (err_short_name)
+            fprintf(stream, " for flag -%s", err_short_name);
+        else
+            fprintf(stream, " for positional argument %s", err_pos_name);
+        fprintf(stream, " got '%s'\n", err_token);
+    }
+#endif
+
+   private:
+    template <std::size_t... I>
+    void register_all(std::index_sequence<I...>) {
+        (register_one<I>(), ...);
+    }
+
+    template <std::size_t I>
+    void register_one() {
+        using T = value_type<I>;
+        const auto &arg = std::get<I>(Spec.args);
+        auto &s = std::get<I>(slots);
+        static_assert(std::get<I>(Spec.args).bind == 0 || detail::is_native<T>,
+                      "only bool, uint64_t, std::string_view and argp::list arguments can be bound");
+
+        if constexpr (detail::is_flag<arg_type<I>>::value) {
+            Argp_Flag_Opt opt{};
+            opt.desc = arg.desc;
+            opt.meta_var = arg.meta_var;
+#ifndef ARGP_MINIMAL
+            opt.bind = arg.bind;
+#endif
+
+            if constexpr (std::is_same_v<T, bool>) {
+                s.handle = argp_flag_bool_(arg.short_name, arg.long_name, opt);
+            } else if constexpr (std::is_same_v<T, uint64_t>) {
+                s.handle = argp_flag_uint_(arg.short_name, arg.long_name, arg.def, opt);
+            } else if constexpr (std::is_same_v<T, list>) {
+                s.handle = argp_flag_list_(arg.short_name, arg.long_name, opt);
+            } else {
+                // string_view defaults need not be NUL terminated, they are applied in get
+                s.handle = argp_flag_str_(arg.short_name, arg.long_name, nullptr, opt);
+            }
+        } else {
+            Argp_Pos_Opt opt{};
+            opt.desc = arg.desc;
+            opt.req = arg.req;
+#ifndef ARGP_MINIMAL
+            opt.bind = arg.bind;
+#endif
+
+            if constexpr (std::is_same_v<T, uint64_t>) {
+                s.handle = argp_pos_uint_(arg.name, arg.def, opt);
+            } else if constexpr (std::is_same_v<T, list>) {
+                s.handle = argp_pos_list_(arg.name, opt);
+            } else {
+                static_assert(!std::is_same_v<T, bool>, "positional arguments cannot be bool");
+                s.handle = argp_pos_str_(arg.name, nullptr, opt);
+            }
+        }
+    }
+
+    template <std::size_t... I>
+    bool convert_all(std::index_sequence<I...>) {
+        return (convert_one<I>() && ...);
+    }
+
+    template <std::size_t I>
+    bool convert_one() {
+        using T = value_type<I>;
+        if constexpr (detail::is_native<T>) {
+            return true;
+        } else {
+            const auto &arg = std::get<I>(Spec.args);
+            auto &s = std::get<I>(slots);
+            const char *token = *static_cast<char *const *>(s.handle);
+
+            s.value = arg.def;
+            if (!token) return true;
+
+            err = detail::convert(token, s.value);
+            if (err == ARGP_NO_ERROR) return true;
+
+            err_token = token;
+            if constexpr (detail::is_flag<arg_type<I>>::value) {
+                err_short_name = arg.short_name;
+                err_long_name = arg.long_name;
+            } else {
+                err_pos_name = arg.name;
+            }
+            return false;
+        }
+    }
+
+    template <std::size_t... I>
+    static auto make_slots(std::index_sequence<I...>) -> std::tuple<detail::slot<value_type<I>>...>;
+
+    decltype(make_slots(std::make_index_sequence<spec_type::size>{})) slots{};
+
+    Argp_Error err = ARGP_NO_ERROR;
+    const char *err_token = nullptr;
+    const char *err_short_name = nullptr;
+    const char *err_long_name = nullptr;
+    const char *err_pos_name = nullptr;
+};
+
+}  // namespace argp
+
+#endif  // ARGPARSE_HPP
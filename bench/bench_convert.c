@@ -0,0 +1,84 @@
+// bench_convert.c -- time of a uint list converted serially and on the worker pool
+//
+// ARGP_PARALLEL_MIN is set to 1 so every parallel run uses the pool, the size at which
+// parallel gets faster than serial is the one to choose for it on a given machine. The
+// second table converts the largest list with 1 to ARGP_THREAD_COUNT threads, it only
+// shows scaling up to the cores the machine has.
+//
+//   make bench
+
+#include <unistd.h>
+
+static long bench_cpus;
+
+#define ARGPARSE_IMPLEMENTATION
+#define ARGP_PARALLEL_MIN 1
+#define ARGP_CPU_COUNT bench_cpus
+#include "../argparse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_MAX (1 << 20)
+#define BENCH_ROUNDS 5
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// best of BENCH_ROUNDS parses of n entries, in nanoseconds per entry
+static double bench_parse(char **argv, int n, bool parallel) {
+    double best = 0;
+    for (int round = 0; round < BENCH_ROUNDS; ++round) {
+        argp_init(n + 1, argv);
+        Argp_Uint_List *list = argp_pos_uint_list("n", .parallel = parallel);
+
+        double start = bench_now();
+        if (!argp_parse_args() || list->size != (size_t)n) {
+            argp_print_error(stderr);
+            exit(1);
+        }
+        double t = bench_now() - start;
+        if (round == 0 || t < best) best = t;
+        argp_free_uint_list(list);
+    }
+    return best * 1e9 / n;
+}
+
+int main(void) {
+    char **argv = (char **)malloc((BENCH_MAX + 2) * sizeof(char *));
+    argv[0] = (char *)"bench";
+    for (int i = 1; i <= BENCH_MAX; ++i) {
+        argv[i] = (char *)malloc(24);
+        snprintf(argv[i], 24, "%llu", 18446744073709551615ull - (unsigned long long)i * 7919);
+    }
+
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    bench_cpus = online;
+    printf("cores online: %ld\n\n", online);
+    printf("%10s %12s %12s %8s\n", "entries", "serial ns", "parallel ns", "speedup");
+    for (int n = 1024; n <= BENCH_MAX; n *= 2) {
+        // argv is rewritten by the parse, restore the end marker of each size
+        char *end = argv[n + 1];
+        argv[n + 1] = NULL;
+        double serial = bench_parse(argv, n, false);
+        double parallel = bench_parse(argv, n, true);
+        argv[n + 1] = end;
+        printf("%10d %12.1f %12.1f %8.2f\n", n, serial, parallel, serial / parallel);
+    }
+
+    argv[BENCH_MAX + 1] = NULL;
+    double serial = bench_parse(argv, BENCH_MAX, false);
+    printf("\n%10s %12s %8s\n", "threads", "ns", "speedup");
+    for (bench_cpus = 1; bench_cpus <= ARGP_THREAD_COUNT; bench_cpus *= 2) {
+        double parallel = bench_parse(argv, BENCH_MAX, true);
+        printf("%10ld %12.1f %8.2f\n", bench_cpus, parallel, serial / parallel);
+    }
+
+    for (int i = 1; i <= BENCH_MAX; ++i) free(argv[i]);
+    free(argv);
+    return 0;
+}
@@ -1,10 +1,13 @@
-#include <stdbool.h>
-#include <stdint.h>
-#include <stdio.h>
+// cc -pthread -o example example.c
 
+// first, so the implementation can define _GNU_SOURCE for fileno under a strict -std=c11
 #define ARGPARSE_IMPLEMENTATION
 #include "argparse.h"
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
 typedef enum {
     MODE_FAST,
     MODE_SLOW,
@@ -122,7 +125,11 @@ int main(int argc, char **argv) {
 
     // parse and handle errors
     if (!argp_parse_args()) {
+#ifndef ARGP_MINIMAL
         argp_print_error(stderr);
+#else
+        fprintf(stderr, "Error: %d\n", (int)argp_error());
+#endif
         return 1;
     }
 
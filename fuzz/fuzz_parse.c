@@ -0,0 +1,443 @@
+// fuzz_parse.c -- fuzzes the parse path of argparse.h
+//
+// An input is a list of lines: the first one declares the arguments, one character each,
+// the ones after it give their names and enum options, the rest is argv.
+//
+//   spec:        ! collect errors  % parse_known_args  ~ strict
+//   flags:       b bool  u uint  z lazy uint  s str  e enum  y lazy enum  x enum set  l list
+//                m map  n map of unique keys  r ranges                    two lines of names
+//   positionals: U uint  S str  N enum  L list  I uint list  J enum list  K, Q parallel uint
+//                and enum list  R ranges                                   one line of name
+//                followed by ^ required, ? optional, or for lists + some, * any, # two
+//   commands:    c under the program  C under the last command           one line of name
+//   enums take one more line of comma separated options
+//
+// Sorted lists and path checks are left out, they read files.
+//
+// Besides crashes and leaks, every run counts the slots its name and map lookups probe, through
+// ARGP_PROBE, and the allocations it makes, and fails if either grows faster than its tokens, so
+// a quadratic path fails as well without depending on the speed of the machine.
+//
+//   make fuzz                  libFuzzer, needs clang
+//   make fuzz-check            the corpus and generated inputs up to 1 MiB, no fuzzer needed
+//   fuzz/fuzz_check FILE...    the given inputs, e.g. afl-fuzz -i fuzz/corpus -o out -- fuzz/fuzz_check @@
+
+#include <stddef.h>
+
+static void *fuzz_realloc(void *p, size_t n);
+static size_t fuzz_probes;
+
+#define ARGPARSE_IMPLEMENTATION
+#define ARGP_REALLOC fuzz_realloc
+#define ARGP_PROBE() (++fuzz_probes)
+#include "../argparse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// cost allowed on top of a fixed part, per token for probes and allocations and per byte for
+// the bytes allocated, loose enough for any spec, a quadratic path passes them by orders of
+// magnitude on the large generated inputs
+#define FUZZ_PROBE_BASE 4096
+#define FUZZ_PROBE_PER_TOKEN 16
+#define FUZZ_ALLOC_BASE 256
+#define FUZZ_ALLOC_PER_TOKEN 1
+#define FUZZ_ALLOC_BYTES_BASE (1u << 20)
+#define FUZZ_ALLOC_BYTES_PER_BYTE 256
+
+#define FUZZ_OPTION_CAP 64
+
+static size_t fuzz_allocs;
+static size_t fuzz_alloc_bytes;
+
+static void *fuzz_realloc(void *p, size_t n) {
+    ++fuzz_allocs;
+    fuzz_alloc_bytes += n;
+    return realloc(p, n);
+}
+
+typedef struct {
+    Argp_Type type;
+    void *val;
+} Fuzz_Arg;
+
+typedef struct {
+    char **lines;
+    size_t count;
+    size_t next;
+} Fuzz_Lines;
+
+static char *fuzz_line(Fuzz_Lines *lines) {
+    return lines->next < lines->count ? lines->lines[lines->next++] : NULL;
+}
+
+static const char *fuzz_name(Fuzz_Lines *lines, const char *fallback) {
+    char *line = fuzz_line(lines);
+    return line && *line ? line : fallback;
+}
+
+// splits a line of options in place, the array is freed after the run
+static const char **fuzz_options(Fuzz_Lines *lines, size_t *count) {
+    const char **options = (const char **)malloc(FUZZ_OPTION_CAP * sizeof(char *));
+    char *line = fuzz_line(lines);
+    *count = 0;
+    for (char *p = line; p && *count < FUZZ_OPTION_CAP;) {
+        options[(*count)++] = p;
+        p = strchr(p, ',');
+        if (p) *p++ = '\0';
+    }
+    return options;
+}
+
+static bool fuzz_is_list(char type) {
+    return type == 'L' || type == 'I' || type == 'J' || type == 'K' || type == 'Q';
+}
+
+static Argp_Pos_Opt fuzz_pos_opt(const char **spec, char type, const bool *command) {
+    Argp_Pos_Opt opt = {0};
+    opt.command = command;
+    opt.parallel = type == 'K' || type == 'Q';
+    for (;; ++*spec) {
+        char m = (*spec)[1];
+        if (m == '^')
+            opt.req = ARGP_REQUIRED;
+        else if (m == '?')
+            opt.nargs = ARGP_NARGS_OPTIONAL;
+        else if (m == '+' && fuzz_is_list(type))
+            opt.nargs = ARGP_NARGS_SOME;
+        else if (m == '*' && fuzz_is_list(type))
+            opt.nargs = ARGP_NARGS_ANY;
+        else if (m == '#' && fuzz_is_list(type))
+            opt.nargs = ARGP_NARGS(2);
+        else
+            return opt;
+    }
+}
+
+static void fuzz_free_value(const Fuzz_Arg *arg) {
+    switch (arg->type) {
+        case ARGP_LIST: argp_free_list((Argp_List *)arg->val); break;
+        case ARGP_MAP: argp_free_map((Argp_Map *)arg->val); break;
+        case ARGP_RANGES: argp_free_ranges((Argp_Ranges *)arg->val); break;
+        case ARGP_UINT_LIST:
+        case ARGP_ENUM_LIST: argp_free_uint_list((Argp_Uint_List *)arg->val); break;
+        default: break;
+    }
+}
+
+typedef struct {
+    Fuzz_Arg args[ARGP_FLAG_CAP + ARGP_POS_CAP + ARGP_COMMAND_CAP];
+    size_t arg_count;
+    const char **options[ARGP_FLAG_CAP + ARGP_POS_CAP];
+    size_t options_count;
+} Fuzz_Spec;
+
+// declares the arguments of spec, with declare false it only skips the lines they take, so
+// that argc is known before argp_init
+static void fuzz_declare(const char *spec, Fuzz_Lines *lines, bool declare, Fuzz_Spec *out) {
+    size_t flag_count = 0, pos_count = 0, command_count = 1;
+    const bool *command = NULL;
+
+    for (const char *t = spec; *t; ++t) {
+        Fuzz_Arg *arg = out->args + out->arg_count;
+        const char *short_name = NULL, *long_name = NULL, *name = NULL;
+        Argp_Flag_Opt flag_opt = {0};
+        flag_opt.command = command;
+        flag_opt.lazy = *t == 'z' || *t == 'y';
+        size_t option_count = 0;
+
+        if (strchr("buzseyxlmnr", *t)) {
+            if (flag_count == ARGP_FLAG_CAP) continue;
+            ++flag_count;
+            short_name = fuzz_name(lines, NULL);
+            long_name = fuzz_name(lines, NULL);
+            if (!short_name && !long_name) short_name = "f";
+        } else if (strchr("USNLIJKQR", *t)) {
+            if (pos_count == ARGP_POS_CAP) continue;
+            ++pos_count;
+            name = fuzz_name(lines, "p");
+        } else if (*t == 'c' || *t == 'C') {
+            if (command_count == ARGP_COMMAND_CAP) continue;
+            ++command_count;
+            name = fuzz_name(lines, "c");
+        } else {
+            continue;
+        }
+        if (strchr("eyxNJQ", *t)) {
+            // splitting writes to the line, the first pass leaves it for the second
+            if (!declare)
+                fuzz_line(lines);
+            else
+                out->options[out->options_count++] = fuzz_options(lines, &option_count);
+        }
+        if (!declare) {
+            if (strchr("USNLIJKQR", *t)) fuzz_pos_opt(&t, *t, NULL);
+            continue;
+        }
+
+        switch (*t) {
+            case 'b': *arg = (Fuzz_Arg){ARGP_BOOL, argp_flag_bool_(short_name, long_name, flag_opt)}; break;
+            case 'u':
+            case 'z': *arg = (Fuzz_Arg){ARGP_UINT, argp_flag_uint_(short_name, long_name, 0, flag_opt)}; break;
+            case 's': *arg = (Fuzz_Arg){ARGP_STR, argp_flag_str_(short_name, long_name, NULL, flag_opt)}; break;
+            case 'e':
+            case 'y':
+                *arg = (Fuzz_Arg){ARGP_ENUM, argp_flag_enum_(short_name, long_name, out->options[out->options_count - 1],
+                                                             option_count, 0, flag_opt)};
+                break;
+            case 'x':
+                *arg = (Fuzz_Arg){ARGP_ENUM_SET, argp_flag_enum_set_(short_name, long_name,
+                                                                     out->options[out->options_count - 1],
+                                                                     option_count, 0, flag_opt)};
+                break;
+            case 'l': *arg = (Fuzz_Arg){ARGP_LIST, argp_flag_list_(short_name, long_name, flag_opt)}; break;
+            case 'm':
+            case 'n':
+                *arg = (Fuzz_Arg){ARGP_MAP, argp_flag_map_(short_name, long_name,
+                                                           *t == 'm' ? ARGP_MAP_LAST_WINS : ARGP_MAP_UNIQUE, flag_opt)};
+                break;
+            case 'r': *arg = (Fuzz_Arg){ARGP_RANGES, argp_flag_ranges_(short_name, long_name, flag_opt)}; break;
+            case 'c':
+            case 'C': {
+                Argp_Command_Opt command_opt = {0};
+                command_opt.command = *t == 'C' ? command : NULL;
+                command = argp_command_(name, command_opt);
+                *arg = (Fuzz_Arg){ARGP_BOOL, (void *)command};
+            } break;
+            default: {
+                char type = *t;
+                Argp_Pos_Opt opt = fuzz_pos_opt(&t, type, command);
+                switch (type) {
+                    case 'U': *arg = (Fuzz_Arg){ARGP_UINT, argp_pos_uint_(name, 0, opt)}; break;
+                    case 'S': *arg = (Fuzz_Arg){ARGP_STR, argp_pos_str_(name, NULL, opt)}; break;
+                    case 'N':
+                        *arg = (Fuzz_Arg){ARGP_ENUM, argp_pos_enum_(name, out->options[out->options_count - 1],
+                                                                    option_count, 0, opt)};
+                        break;
+                    case 'L': *arg = (Fuzz_Arg){ARGP_LIST, argp_pos_list_(name, opt)}; break;
+                    case 'I':
+                    case 'K': *arg = (Fuzz_Arg){ARGP_UINT_LIST, argp_pos_uint_list_(name, opt)}; break;
+                    case 'J':
+                    case 'Q':
+                        *arg = (Fuzz_Arg){ARGP_ENUM_LIST, argp_pos_enum_list_(name, out->options[out->options_count - 1],
+                                                                              option_count, opt)};
+                        break;
+                    case 'R': *arg = (Fuzz_Arg){ARGP_RANGES, argp_pos_ranges_(name, opt)}; break;
+                }
+            } break;
+        }
+        ++out->arg_count;
+    }
+}
+
+static void fuzz_check_cost(const char *what, size_t cost, size_t base, size_t per_unit, size_t units) {
+    if (cost <= base + per_unit * (uint64_t)units) return;
+    fprintf(stderr, "fuzz: %zu %s for %zu units of input\n", cost, what, units);
+    abort();
+}
+
+static void fuzz_run(const uint8_t *data, size_t size) {
+    static FILE *devnull;
+    if (!devnull) devnull = fopen("/dev/null", "w");
+
+    // argv is written in place, as by a shell
+    char *buf = (char *)malloc(size + 1);
+    memcpy(buf, data, size);
+    buf[size] = '\0';
+
+    Fuzz_Lines lines = {(char **)malloc((size + 2) * sizeof(char *)), 0, 0};
+    for (char *p = buf;;) {
+        lines.lines[lines.count++] = p;
+        p = (char *)memchr(p, '\n', (size_t)(buf + size - p));
+        if (!p) break;
+        *p++ = '\0';
+    }
+    const char *spec = fuzz_line(&lines);
+    bool known = strchr(spec, '%') != NULL;
+
+    // the lines after the ones the spec takes are argv
+    Fuzz_Spec *decl = (Fuzz_Spec *)calloc(1, sizeof(Fuzz_Spec));
+    size_t spec_lines = lines.next;
+    fuzz_declare(spec, &lines, false, decl);
+    size_t argv_begin = lines.next;
+    int argc = (int)(lines.count - argv_begin) + 1;
+    char **argv = (char **)malloc(((size_t)argc + 1) * sizeof(char *));
+    argv[0] = (char *)"fuzz";
+    memcpy(argv + 1, lines.lines + argv_begin, (size_t)(argc - 1) * sizeof(char *));
+    argv[argc] = NULL;
+    lines.next = spec_lines;
+
+    // every line and every character of the spec is a token
+    size_t tokens = lines.count + strlen(spec);
+    fuzz_probes = 0;
+    fuzz_allocs = 0;
+    fuzz_alloc_bytes = 0;
+
+    Argp_Opt opt = {0};
+    opt.strict = strchr(spec, '~') != NULL;
+    opt.collect_errors = strchr(spec, '!') != NULL;
+    argp_init_(argc, argv, opt);
+    fuzz_declare(spec, &lines, true, decl);
+
+    bool ok;
+    if (known) {
+        int rest_argc;
+        char **rest_argv;
+        ok = argp_parse_known_args(&rest_argc, &rest_argv);
+        if (ok && (rest_argc > argc || rest_argv[rest_argc] != NULL)) abort();
+    } else {
+        ok = argp_parse_args();
+    }
+
+    const Argp_Error_Record *records;
+    size_t total, count = argp_error_records(&records, &total);
+    if (ok != (argp_error() == ARGP_NO_ERROR) || count > total || count > ARGP_ERROR_CAP) abort();
+    for (size_t i = 0; i < count; ++i) {
+        if (records[i].argv_index >= argc) abort();
+    }
+    argp_print_error(devnull);
+
+    for (size_t i = 0; i < decl->arg_count; ++i) {
+        Argp_Info info;
+        if (!argp_info(decl->args[i].val, &info)) abort();
+        if (info.type == ARGP_UINT && info.kind == ARGP_KIND_FLAG)
+            argp_get_uint((const uint64_t *)decl->args[i].val);
+        else if (info.type == ARGP_ENUM && info.kind == ARGP_KIND_FLAG)
+            argp_get_enum((const size_t *)decl->args[i].val);
+        else
+            argp_resolve(decl->args[i].val);
+    }
+    if (ok) {
+        argp_dump(devnull, ARGP_DUMP_JSON);
+        argp_snapshot_write(fileno(devnull));
+    }
+
+    fuzz_check_cost("probes", fuzz_probes, FUZZ_PROBE_BASE, FUZZ_PROBE_PER_TOKEN, tokens);
+    fuzz_check_cost("allocations", fuzz_allocs, FUZZ_ALLOC_BASE, FUZZ_ALLOC_PER_TOKEN, tokens);
+    fuzz_check_cost("bytes allocated", fuzz_alloc_bytes, FUZZ_ALLOC_BYTES_BASE, FUZZ_ALLOC_BYTES_PER_BYTE, size);
+
+    for (size_t i = 0; i < decl->arg_count; ++i) fuzz_free_value(decl->args + i);
+    for (size_t i = 0; i < decl->options_count; ++i) free((void *)decl->options[i]);
+    free(decl);
+    free(argv);
+    free(lines.lines);
+    free(buf);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    fuzz_run(data, size);
+    return 0;
+}
+
+#ifndef ARGP_LIBFUZZER
+// xorshift with a fixed seed, every run generates the same inputs
+static uint64_t fuzz_state = 0x9e3779b97f4a7c15ull;
+
+static uint64_t fuzz_rand(uint64_t n) {
+    fuzz_state ^= fuzz_state << 13;
+    fuzz_state ^= fuzz_state >> 7;
+    fuzz_state ^= fuzz_state << 17;
+    return fuzz_state % n;
+}
+
+static const char *const fuzz_words[] = {"a", "b", "ab", "v", "x", "run", "add", "tls", "gzip", ""};
+#define FUZZ_WORD_COUNT (sizeof(fuzz_words) / sizeof(fuzz_words[0]))
+
+static void fuzz_put(char **p, const char *s) {
+    size_t n = strlen(s);
+    memcpy(*p, s, n);
+    *p += n;
+}
+
+static void fuzz_put_number(char **p) {
+    *p += sprintf(*p, "%llu", (unsigned long long)(fuzz_rand(4) ? fuzz_rand(1000) : fuzz_state));
+}
+
+// a spec drawn from every kind of argument, then size bytes of tokens built from the same
+// words, so that most of them name a flag, a command or an option
+static size_t fuzz_generate(char *out, size_t size) {
+    static const char kinds[] = "!%~buzseyxlmnrUSNLIJKQRcC^?+*#";
+    char *p = out;
+
+    size_t spec_len = 1 + fuzz_rand(24);
+    for (size_t i = 0; i < spec_len; ++i) *p++ = kinds[fuzz_rand(sizeof(kinds) - 1)];
+    for (size_t i = 0; i < 3 * spec_len; ++i) {
+        *p++ = '\n';
+        fuzz_put(&p, fuzz_words[fuzz_rand(FUZZ_WORD_COUNT)]);
+        if (fuzz_rand(2)) {
+            *p++ = ',';
+            fuzz_put(&p, fuzz_words[fuzz_rand(FUZZ_WORD_COUNT)]);
+        }
+    }
+
+    while ((size_t)(p - out) + 256 < size) {
+        *p++ = '\n';
+        const char *word = fuzz_words[fuzz_rand(FUZZ_WORD_COUNT)];
+        switch (fuzz_rand(10)) {
+            case 0: fuzz_put(&p, "-"); fuzz_put(&p, word); break;
+            case 1: fuzz_put(&p, "--"); fuzz_put(&p, word); break;
+            case 2: fuzz_put(&p, "--"); fuzz_put(&p, word); fuzz_put(&p, "="); fuzz_put_number(&p); break;
+            case 3: fuzz_put_number(&p); break;
+            case 4: {
+                fuzz_put_number(&p);
+                for (uint64_t k = fuzz_rand(8); k-- > 0;) {
+                    fuzz_put(&p, fuzz_rand(2) ? "," : "-");
+                    fuzz_put_number(&p);
+                }
+            } break;
+            case 5: fuzz_put(&p, word); fuzz_put(&p, "="); fuzz_put(&p, word); break;
+            case 6: {
+                fuzz_put(&p, word);
+                for (uint64_t k = fuzz_rand(4); k-- > 0;) {
+                    fuzz_put(&p, ",");
+                    fuzz_put(&p, fuzz_words[fuzz_rand(FUZZ_WORD_COUNT)]);
+                }
+            } break;
+            case 7: fuzz_put(&p, fuzz_rand(8) ? word : "--"); break;
+            default: fuzz_put(&p, word); break;
+        }
+    }
+    return (size_t)(p - out);
+}
+
+static bool fuzz_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    uint8_t *data = NULL;
+    size_t size = 0, cap = 0, n;
+    do {
+        if (size == cap) data = (uint8_t *)realloc(data, cap = cap ? cap * 2 : 4096);
+        n = fread(data + size, 1, cap - size, f);
+        size += n;
+    } while (n);
+    fclose(f);
+
+    fuzz_run(data, size);
+    free(data);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i) {
+            if (!fuzz_file(argv[i])) return 1;
+        }
+        return 0;
+    }
+
+    // many small inputs for coverage, a few large ones for the cost bounds
+    size_t max = 1 << 20;
+    char *data = (char *)malloc(max);
+    for (int i = 0; i < 4000; ++i) {
+        size_t size = i % 500 == 499 ? max : 64 + fuzz_rand(4096);
+        fuzz_run((const uint8_t *)data, fuzz_generate(data, size));
+    }
+    free(data);
+    printf("fuzz: ok\n");
+    return 0;
+}
+#endif
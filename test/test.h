@@ -0,0 +1,56 @@
+// test.h -- checks shared by the tests in test/, each test is a program run by make test
+//
+// Include after argparse.h.
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_ARG_CAP 32
+
+static int test_failures;
+static const char *test_case;  // command line of the case being checked, NULL if none
+
+#define EXPECT(cond)                                                                          \
+    do {                                                                                      \
+        if (!(cond)) {                                                                        \
+            fprintf(stderr, "%s:%d: %s%s%s\n", __FILE__, __LINE__, test_case ? test_case : "", \
+                    test_case ? ": " : "", #cond);                                            \
+            ++test_failures;                                                                  \
+        }                                                                                     \
+    } while (0)
+
+static char test_buf[512];
+static char *test_argv[TEST_ARG_CAP + 1];
+
+// splits line on spaces into test_argv, the first word is the program name
+// the words are overwritten by the next call
+static inline int test_split(const char *line) {
+    int argc = 0;
+    test_case = line;
+    snprintf(test_buf, sizeof(test_buf), "%s", line);
+    for (char *word = strtok(test_buf, " "); word && argc < TEST_ARG_CAP; word = strtok(NULL, " "))
+        test_argv[argc++] = word;
+    test_argv[argc] = NULL;
+    return argc;
+}
+
+// the entries of list joined with commas
+static inline const char *test_join(const Argp_List *list) {
+    static char joined[512];
+    size_t n = 0;
+    joined[0] = '\0';
+    for (size_t i = 0; i < list->size && n < sizeof(joined); ++i)
+        n += (size_t)snprintf(joined + n, sizeof(joined) - n, "%s%s", i ? "," : "", list->items[i]);
+    return joined;
+}
+
+// exit status of the test, prints name: ok if every check passed
+static inline int test_done(const char *name) {
+    if (test_failures) return 1;
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+#endif  // TEST_H
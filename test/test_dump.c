@@ -0,0 +1,67 @@
+// test_dump.c -- argp_dump prints the selected command path as text and as JSON
+//
+//   make test
+
+#define ARGPARSE_IMPLEMENTATION
+#include "../argparse.h"
+
+#include <stdlib.h>
+
+#include "test.h"
+
+static const char *modes[] = {"debug", "release"};
+
+// dumps the arguments of line and compares the output with want
+static void test_dump(const char *line, Argp_Dump_Format format, const char *want) {
+    argp_init(test_split(line), test_argv);
+    uint64_t *jobs = argp_flag_uint("j", "jobs", 1);
+    Argp_List *tags = argp_flag_list("t", NULL);
+    bool *build = argp_command("build");
+    size_t *mode = argp_flag_enum("m", "mode", modes, 2, 0, .command = build);
+    char **dir = argp_pos_str("dir", (char *)"out", .command = build);
+    bool *run = argp_command("run");
+    bool *trace = argp_flag_bool(NULL, "trace", .command = run);
+    (void)jobs, (void)mode, (void)dir, (void)trace;
+    EXPECT(argp_parse_args());
+
+    FILE *f = tmpfile();
+    EXPECT(argp_dump(f, format));
+    static char got[1024];
+    rewind(f);
+    size_t n = fread(got, 1, sizeof(got) - 1, f);
+    got[n] = '\0';
+    fclose(f);
+    EXPECT(strcmp(got, want) == 0);
+    argp_free_list(tags);
+}
+
+int main(void) {
+    test_dump("prog -t a -t \"b build --mode release", ARGP_DUMP_TEXT,
+              "command: prog build\n"
+              "prog:\n"
+              "  --jobs                1 (default)\n"
+              "  -t                    a, \"b\n"
+              "build:\n"
+              "  --mode                release\n"
+              "  dir                   out (default)\n");
+    // strings are escaped in JSON
+    test_dump("prog -t a -t \"b build --mode release", ARGP_DUMP_JSON,
+              "{\n"
+              "  \"command\": [\"prog\", \"build\"],\n"
+              "  \"arguments\": [\n"
+              "    {\"command\": \"prog\", \"name\": \"jobs\", \"kind\": \"flag\", \"value\": 1, \"default\": true},\n"
+              "    {\"command\": \"prog\", \"name\": \"t\", \"kind\": \"flag\", \"value\": [\"a\", \"\\\"b\"], \"default\": false},\n"
+              "    {\"command\": \"build\", \"name\": \"mode\", \"kind\": \"flag\", \"value\": \"release\", \"default\": false},\n"
+              "    {\"command\": \"build\", \"name\": \"dir\", \"kind\": \"positional\", \"value\": \"out\", \"default\": true}\n"
+              "  ]\n"
+              "}\n");
+    // only the commands on the selected path are dumped
+    test_dump("prog -j 2 run", ARGP_DUMP_TEXT,
+              "command: prog run\n"
+              "prog:\n"
+              "  --jobs                2\n"
+              "  -t                     (default)\n"
+              "run:\n"
+              "  --trace               false (default)\n");
+    return test_done("dump");
+}
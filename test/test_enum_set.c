@@ -0,0 +1,50 @@
+// test_enum_set.c -- how argp_flag_enum_set builds a set from comma-separated options
+//
+//   make test
+
+#define ARGPARSE_IMPLEMENTATION
+#include "../argparse.h"
+
+#include "test.h"
+
+static const char *features[] = {"lto", "pgo", "simd", "asan"};
+
+#define BIT(i) ((uint64_t)1 << (i))
+
+static void test_set(const char *line, Argp_Error err, uint64_t want) {
+    argp_init(test_split(line), test_argv);
+    uint64_t *set = argp_flag_enum_set("e", "enable", features, 4, BIT(0) | BIT(3));
+    EXPECT(argp_parse_args() == (err == ARGP_NO_ERROR));
+    EXPECT(argp_error() == err);
+    if (err == ARGP_NO_ERROR) EXPECT(*set == want);
+}
+
+// bit 63 belongs to the last of 64 options
+static void test_widest(void) {
+    static char names[64][4];
+    const char *options[64];
+    for (int i = 0; i < 64; ++i) {
+        snprintf(names[i], sizeof(names[i]), "o%d", i);
+        options[i] = names[i];
+    }
+    argp_init(test_split("prog --enable o0,o63"), test_argv);
+    uint64_t *set = argp_flag_enum_set("e", "enable", options, 64, 0);
+    EXPECT(argp_parse_args());
+    EXPECT(*set == (BIT(0) | BIT(63)));
+}
+
+int main(void) {
+    test_set("prog", ARGP_NO_ERROR, BIT(0) | BIT(3));
+    // the first occurrence replaces the default, later ones add to it
+    test_set("prog -e pgo", ARGP_NO_ERROR, BIT(1));
+    test_set("prog --enable=pgo,simd", ARGP_NO_ERROR, BIT(1) | BIT(2));
+    test_set("prog -e pgo -e simd --enable pgo", ARGP_NO_ERROR, BIT(1) | BIT(2));
+    test_set("prog -e lto,lto", ARGP_NO_ERROR, BIT(0));
+    test_set("prog -e lto,ubsan", ARGP_ERROR_UNKNOWN_ENUM, 0);
+    test_set("prog -e lto,,pgo", ARGP_ERROR_UNKNOWN_ENUM, 0);
+    test_set("prog -e simd,", ARGP_ERROR_UNKNOWN_ENUM, 0);
+    test_set("prog -e lt", ARGP_ERROR_UNKNOWN_ENUM, 0);
+    test_set("prog -e", ARGP_ERROR_NO_VALUE, 0);
+    test_widest();
+    return test_done("enum set");
+}
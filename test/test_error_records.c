@@ -0,0 +1,101 @@
+// test_error_records.c -- errors recorded by a parse with .collect_errors
+//
+//   make test
+
+#define ARGPARSE_IMPLEMENTATION
+#include "../argparse.h"
+
+#include "test.h"
+
+static const char *modes[] = {"fast", "safe"};
+
+static size_t parse(const char *line, bool collect, const Argp_Error_Record **records, size_t *total) {
+    argp_init(test_split(line), test_argv, .collect_errors = collect);
+    argp_flag_uint("j", "jobs", 1);
+    argp_flag_enum("m", "mode", modes, 2, 0);
+    Argp_List *tags = argp_flag_list("t", NULL);
+    argp_pos_uint("count", 0, .req = ARGP_REQUIRED);
+    EXPECT(!argp_parse_args());
+    argp_free_list(tags);
+    return argp_error_records(records, total);
+}
+
+// every error found in argv order, with what it belongs to
+static void test_order(void) {
+    const Argp_Error_Record *r;
+    size_t total;
+    size_t n = parse("prog -j x -m slow -t ok --jobs=99999999999999999999 7", true, &r, &total);
+    EXPECT(n == 3 && total == 3);
+    EXPECT(argp_error() == ARGP_ERROR_INVALID_NUMBER);
+    if (n != 3) return;
+
+    EXPECT(r[0].code == ARGP_ERROR_INVALID_NUMBER && r[0].argv_index == 2);
+    EXPECT(strcmp(r[0].short_name, "j") == 0 && strcmp(r[0].long_name, "jobs") == 0);
+    EXPECT(strcmp(r[0].token, "x") == 0 && r[0].pos_name == NULL && r[0].index == SIZE_MAX);
+
+    EXPECT(r[1].code == ARGP_ERROR_UNKNOWN_ENUM && r[1].argv_index == 4 && strcmp(r[1].token, "slow") == 0);
+    EXPECT(r[1].option_count == 2 && r[1].options && strcmp(r[1].options[1], "safe") == 0);
+
+    EXPECT(r[2].code == ARGP_ERROR_INTEGER_OVERFLOW && r[2].argv_index == 7);
+    EXPECT(strcmp(r[2].token, "99999999999999999999") == 0);
+}
+
+// errors that have no token come after the others
+static void test_untied(void) {
+    const Argp_Error_Record *r;
+    size_t total;
+    size_t n = parse("prog -j x 1 2", true, &r, &total);
+    EXPECT(n == 2 && total == 2);
+    if (n == 2) {
+        EXPECT(r[0].code == ARGP_ERROR_INVALID_NUMBER && r[0].argv_index == 2);
+        EXPECT(r[1].code == ARGP_ERROR_UNKNOWN && r[1].argv_index == 4 && strcmp(r[1].token, "2") == 0);
+    }
+
+    n = parse("prog -j x", true, &r, &total);
+    EXPECT(n == 2 && total == 2);
+    if (n == 2) {
+        EXPECT(r[0].code == ARGP_ERROR_INVALID_NUMBER);
+        EXPECT(r[1].code == ARGP_ERROR_NO_VALUE && r[1].argv_index == -1);
+        EXPECT(r[1].token == NULL && strcmp(r[1].pos_name, "count") == 0);
+    }
+}
+
+// without .collect_errors the parse stops at the first error and records nothing
+static void test_not_collected(void) {
+    const Argp_Error_Record *r;
+    size_t total;
+    EXPECT(parse("prog -j x -m slow", false, &r, &total) == 0 && total == 0);
+    EXPECT(argp_error() == ARGP_ERROR_INVALID_NUMBER);
+}
+
+// past ARGP_ERROR_CAP errors are only counted
+static void test_cap(void) {
+    enum { ERRORS = ARGP_ERROR_CAP + 8 };
+    static char *argv[2 * ERRORS + 3];
+    int argc = 0;
+    argv[argc++] = (char *)"prog";
+    for (int i = 0; i < ERRORS; ++i) {
+        argv[argc++] = (char *)"-j";
+        argv[argc++] = (char *)"x";
+    }
+    argv[argc++] = (char *)"1";
+    argv[argc] = NULL;
+    test_case = "too many errors";
+
+    argp_init(argc, argv, .collect_errors = true);
+    argp_flag_uint("j", "jobs", 1);
+    argp_pos_uint("count", 0, .req = ARGP_REQUIRED);
+    EXPECT(!argp_parse_args());
+    const Argp_Error_Record *r;
+    size_t total;
+    EXPECT(argp_error_records(&r, &total) == ARGP_ERROR_CAP && total == ERRORS);
+    EXPECT(r[ARGP_ERROR_CAP - 1].argv_index == 2 * ARGP_ERROR_CAP);
+}
+
+int main(void) {
+    test_order();
+    test_untied();
+    test_not_collected();
+    test_cap();
+    return test_done("error records");
+}
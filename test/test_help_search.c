@@ -0,0 +1,65 @@
+// test_help_search.c -- which arguments argp_help_search lists and in which order
+//
+//   make test
+
+#define ARGPARSE_IMPLEMENTATION
+#include "../argparse.h"
+
+#include "test.h"
+
+static const char *formats[] = {"json", "yaml", "color"};
+
+static void spec(void) {
+    argp_flag_bool("v", "verbose", .desc = "print more");
+    argp_flag_bool(NULL, "color", .desc = "colorize the output");
+    argp_flag_enum("f", "format", formats, 3, 0, .desc = "output format");
+    bool *remote = argp_command("remote", .desc = "manage remotes");
+    bool *add = argp_command("add", .desc = "add a remote", .command = remote);
+    argp_pos_str("url", NULL, .desc = "address of the remote", .command = add);
+    argp_flag_bool("n", "dry-run", .desc = "only print what would be added", .command = add);
+}
+
+// searches term and compares the output with want
+static void test_search(const char *term, size_t count_want, const char *want) {
+    test_case = term;
+    argp_init(test_split("prog"), test_argv, .help_search = true);
+    spec();
+
+    FILE *f = tmpfile();
+    EXPECT(argp_help_search(f, term) == count_want);
+    static char got[2048];
+    rewind(f);
+    size_t n = fread(got, 1, sizeof(got) - 1, f);
+    got[n] = '\0';
+    fclose(f);
+    EXPECT(strcmp(got, want) == 0);
+}
+
+int main(void) {
+    // a name scores above an enum option of the same word
+    test_search("color", 2,
+                "  prog --color          colorize the output\n"
+                "  prog -f, --format {json,yaml,color}\n"
+                "                        output format\n");
+    // then the command path above the description, ties in declaration order
+    test_search("remote", 4,
+                "  prog remote           manage remotes\n"
+                "  prog remote add       add a remote\n"
+                "  prog remote add -n, --dry-run\n"
+                "                        only print what would be added\n"
+                "  prog remote add url   address of the remote\n");
+    // leading dashes are dropped and case is ignored, names match whole
+    test_search("--DRY-RUN", 1,
+                "  prog remote add -n, --dry-run\n"
+                "                        only print what would be added\n");
+    // a word prefix in a description scores below the command path
+    test_search("add", 3,
+                "  prog remote add       add a remote\n"
+                "  prog remote add -n, --dry-run\n"
+                "                        only print what would be added\n"
+                "  prog remote add url   address of the remote\n");
+    test_search("ver", 1, "  prog -v, --verbose    print more\n");
+    test_search("nothing", 0, "no arguments match 'nothing'\n");
+    test_search("-", 0, "no arguments match ''\n");
+    return test_done("help search");
+}
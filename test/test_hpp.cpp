@@ -0,0 +1,68 @@
+// test_hpp.cpp -- the typed C++ layer of argparse.hpp, built with -Wpedantic as C++17
+//
+//   make test
+
+#define ARGPARSE_IMPLEMENTATION
+#include "../argparse.hpp"
+
+#include "test.h"
+
+struct Config {
+    uint64_t jobs;
+    bool verbose;
+    char *name;
+    Argp_List files;
+};
+
+inline constexpr argp::flag<uint64_t> jobs{"j", "jobs", 1, "parallel jobs", "N", ARGP_BIND(Config, jobs)};
+inline constexpr argp::flag<bool> verbose{"v", "verbose", false, "print more", nullptr, ARGP_BIND(Config, verbose)};
+inline constexpr argp::flag<std::string_view> name{"n", "name", "anon", "who", nullptr, ARGP_BIND(Config, name)};
+inline constexpr argp::flag<double> ratio{nullptr, "ratio", 0.5, "compression ratio"};
+inline constexpr argp::flag<int> level{"l", nullptr, -1, "level"};
+inline constexpr argp::pos<argp::list> files{"files", {}, "input files", ARGP_OPTIONAL, ARGP_BIND(Config, files)};
+inline constexpr auto spec = argp::make_spec(jobs, verbose, name, ratio, level, files);
+
+static_assert(spec.index_of(ratio) == 3 && spec.index_of(files) == 5);
+
+static void test_values() {
+    argp::parser<spec> args(test_split("prog -j 4 --ratio=0.25 -l -3"), test_argv);
+    EXPECT(args.parse());
+    EXPECT(args.get<jobs>() == 4 && !args.get<verbose>());
+    EXPECT(args.get<name>() == "anon");
+    EXPECT(args.get<ratio>() == 0.25 && args.get<level>() == -3);
+    EXPECT(args.get<files>().empty());
+}
+
+// numbers go through std::from_chars in the C library too, with the same errors as in C
+static void test_errors(const char *line, Argp_Error err) {
+    argp::parser<spec> args(test_split(line), test_argv);
+    EXPECT(!args.parse());
+    EXPECT(argp_error() == err);
+}
+
+// the bound struct follows every parse and reload
+static void test_bind() {
+    Config cfg{};
+    argp::parser<spec> args(test_split("prog -v -n ada x"), test_argv);
+    EXPECT(args.parse(cfg));
+    EXPECT(cfg.jobs == 1 && cfg.verbose && strcmp(cfg.name, "ada") == 0);
+    EXPECT(cfg.files.size == 1 && strcmp(cfg.files.items[0], "x") == 0);
+
+    static char a0[] = "prog", a1[] = "-j", a2[] = "9", a3[] = "y", a4[] = "z";
+    static char *reload[] = {a0, a1, a2, a3, a4, nullptr};
+    EXPECT(argp_reload(5, reload));
+    EXPECT(cfg.jobs == 9 && !cfg.verbose && cfg.name == nullptr);
+    EXPECT(cfg.files.size == 2 && strcmp(cfg.files.items[1], "z") == 0);
+    argp::list_view f = args.get<files>();
+    EXPECT(f.size() == 2 && f[1] == cfg.files.items[1]);
+}
+
+int main() {
+    test_values();
+    test_errors("prog -j 18446744073709551616", ARGP_ERROR_INTEGER_OVERFLOW);
+    test_errors("prog -j 99999999999999999999x", ARGP_ERROR_INVALID_NUMBER);
+    test_errors("prog -j -1", ARGP_ERROR_INVALID_NUMBER);
+    test_errors("prog -j +1", ARGP_ERROR_INVALID_NUMBER);
+    test_bind();
+    return test_done("hpp");
+}
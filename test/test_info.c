@@ -0,0 +1,82 @@
+// test_info.c -- names resolve through the name table and argp_info describes every handle
+//
+//   make test
+
+#define ARGPARSE_IMPLEMENTATION
+#include "../argparse.h"
+
+#include "test.h"
+
+// each command has its own names, the same flag name can be declared under both
+static void test_scopes(const char *line, bool build_want, bool build_v, bool run_v) {
+    argp_init(test_split(line), test_argv);
+    bool *build = argp_command("build");
+    bool *bv = argp_flag_bool("v", "verbose", .command = build);
+    bool *run = argp_command("run");
+    bool *rv = argp_flag_bool("v", "verbose", .command = run);
+    EXPECT(argp_parse_args());
+    EXPECT(*build == build_want && *run == !build_want);
+    EXPECT(*bv == build_v && *rv == run_v);
+}
+
+// close to ARGP_FLAG_CAP flags
+static void test_many_names(void) {
+    enum { FLAGS = 120 };
+    static char longs[FLAGS][8];
+    uint64_t *vals[FLAGS];
+    argp_init(test_split("prog --f0 1 --f119=3 --f73 5"), test_argv);
+    for (int i = 0; i < FLAGS; ++i) {
+        snprintf(longs[i], sizeof(longs[i]), "f%d", i);
+        vals[i] = argp_flag_uint(NULL, longs[i], 0);
+    }
+    EXPECT(argp_parse_args());
+    EXPECT(*vals[0] == 1 && *vals[119] == 3 && *vals[73] == 5 && *vals[1] == 0);
+    EXPECT(strcmp(argp_name(vals[97]), "f97") == 0);
+
+    argp_init(test_split("prog --f120 1"), test_argv);
+    for (int i = 0; i < FLAGS; ++i) argp_flag_uint(NULL, longs[i], 0);
+    EXPECT(!argp_parse_args());
+    EXPECT(argp_error() == ARGP_ERROR_UNKNOWN);
+}
+
+static void test_info(void) {
+    argp_init(test_split("prog -j 4 build out"), test_argv);
+    uint64_t *jobs = argp_flag_uint("j", "jobs", 1, .desc = "parallel jobs");
+    bool *quiet = argp_flag_bool("q", NULL);
+    bool *build = argp_command("build", .desc = "compile");
+    char **dir = argp_pos_str("dir", (char *)"bin", .command = build);
+    EXPECT(argp_parse_args());
+
+    Argp_Info info;
+    EXPECT(argp_info(jobs, &info));
+    EXPECT(info.kind == ARGP_KIND_FLAG && info.type == ARGP_UINT);
+    EXPECT(strcmp(info.name, "jobs") == 0 && strcmp(info.desc, "parallel jobs") == 0);
+    EXPECT(info.command == NULL && *(const uint64_t *)info.def == 1);
+    EXPECT(info.set && info.source == ARGP_SOURCE_ARGV);
+
+    EXPECT(argp_info(quiet, &info));
+    EXPECT(strcmp(info.name, "q") == 0 && !info.set && info.source == ARGP_SOURCE_DEFAULT);
+
+    EXPECT(argp_info(build, &info));
+    EXPECT(info.kind == ARGP_KIND_COMMAND && strcmp(info.name, "build") == 0);
+    EXPECT(info.command == NULL && info.def == NULL && info.set);
+
+    EXPECT(argp_info(dir, &info));
+    EXPECT(info.kind == ARGP_KIND_POS && info.type == ARGP_STR && info.command == build);
+    EXPECT(strcmp(*(char *const *)info.def, "bin") == 0 && info.set);
+
+    // pointers into a handle or outside the library are not handles
+    uint64_t local = 0;
+    EXPECT(!argp_info(&local, &info));
+    EXPECT(!argp_info((const char *)jobs + 1, &info));
+    EXPECT(argp_name(&local) == NULL);
+}
+
+int main(void) {
+    test_scopes("prog build -v", true, true, false);
+    test_scopes("prog run --verbose", false, false, true);
+    test_scopes("prog run", false, false, false);
+    test_many_names();
+    test_info();
+    return test_done("info");
+}
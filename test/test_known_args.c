@@ -0,0 +1,63 @@
+// test_known_args.c -- what argp_parse_known_args passes through and in which order
+//
+//   make test
+
+#define ARGPARSE_IMPLEMENTATION
+#include "../argparse.h"
+
+#include "test.h"
+
+// the arguments passed through after argv[0], joined with spaces
+static const char *passed(int argc, char **argv) {
+    static char s[256];
+    size_t n = 0;
+    s[0] = '\0';
+    for (int i = 1; i < argc && n < sizeof(s); ++i)
+        n += (size_t)snprintf(s + n, sizeof(s) - n, "%s%s", i > 1 ? " " : "", argv[i]);
+    return s;
+}
+
+static void test_known(const char *line, const char *want, uint64_t jobs_want, const char *file_want) {
+    argp_init(test_split(line), test_argv);
+    uint64_t *jobs = argp_flag_uint("j", "jobs", 1);
+    char **file = argp_pos_str("file", (char *)"-");
+    int argc;
+    char **argv;
+    EXPECT(argp_parse_known_args(&argc, &argv));
+    EXPECT(argv == test_argv && argv[argc] == NULL);
+    EXPECT(strcmp(argv[0], "prog") == 0);
+    EXPECT(strcmp(passed(argc, argv), want) == 0);
+    EXPECT(*jobs == jobs_want && strcmp(*file, file_want) == 0);
+}
+
+// known flags are still checked, and a subcommand sees the unknown options after it
+static void test_commands(void) {
+    argp_init(test_split("prog -j x"), test_argv);
+    argp_flag_uint("j", "jobs", 1);
+    int argc;
+    char **argv;
+    EXPECT(!argp_parse_known_args(&argc, &argv));
+    EXPECT(argp_error() == ARGP_ERROR_INVALID_NUMBER);
+
+    argp_init(test_split("prog -q run -q --fast target extra"), test_argv);
+    bool *quiet = argp_flag_bool("q", NULL);
+    bool *run = argp_command("run");
+    char **target = argp_pos_str("target", NULL, .command = run);
+    EXPECT(argp_parse_known_args(&argc, &argv));
+    EXPECT(*quiet && *run && strcmp(*target, "target") == 0);
+    EXPECT(strcmp(passed(argc, argv), "-q --fast extra") == 0);
+}
+
+int main(void) {
+    test_known("prog", "", 1, "-");
+    test_known("prog -j 2 in", "", 2, "in");
+    test_known("prog -x in --jobs=3 --color=always", "-x --color=always", 3, "in");
+    // positional arguments with no place keep their order among the passed arguments
+    test_known("prog in out -j 4 more", "out more", 4, "in");
+    test_known("prog a -z b -j 4 c", "-z b c", 4, "a");
+    // -- is dropped and everything after it is passed, even known flags
+    test_known("prog -v in -- -j 5 x", "-v -j 5 x", 1, "in");
+    test_known("prog -- in", "in", 1, "-");
+    test_commands();
+    return test_done("known args");
+}
@@ -0,0 +1,76 @@
+// test_lazy.c -- lazy flags keep their token until the value is first read
+//
+//   make test
+
+#define ARGPARSE_IMPLEMENTATION
+#include "../argparse.h"
+
+#include "test.h"
+
+static const char *levels[] = {"low", "mid", "high"};
+
+static void test_valid(void) {
+    argp_init(test_split("prog -j 12 --level high"), test_argv);
+    uint64_t *jobs = argp_flag_uint("j", "jobs", 1, .lazy = true);
+    size_t *level = argp_flag_enum("l", "level", levels, 3, 0, .lazy = true);
+    EXPECT(argp_parse_args());
+    // the value holds the default until it is resolved
+    EXPECT(*jobs == 1 && *level == 0);
+    EXPECT(argp_get_uint(jobs) == 12 && *jobs == 12);
+    EXPECT(argp_resolve(level) && *level == 2);
+    EXPECT(argp_get_enum(level) == 2);
+}
+
+// a bad token is only found when it is read, and reads as the default
+static void test_invalid(void) {
+    argp_init(test_split("prog -j many -l top"), test_argv);
+    uint64_t *jobs = argp_flag_uint("j", "jobs", 1, .lazy = true);
+    size_t *level = argp_flag_enum("l", "level", levels, 3, 1, .lazy = true);
+    bool *quiet = argp_flag_bool("q", NULL);
+    EXPECT(argp_parse_args());
+    EXPECT(argp_error() == ARGP_NO_ERROR);
+
+    EXPECT(argp_get_uint(jobs) == 1);
+    EXPECT(argp_error() == ARGP_ERROR_INVALID_NUMBER);
+    EXPECT(!argp_resolve(level));
+    EXPECT(argp_error() == ARGP_ERROR_UNKNOWN_ENUM && argp_get_enum(level) == 1);
+
+    // handles of other arguments resolve to nothing
+    EXPECT(argp_resolve(quiet));
+
+    // argp_info resolves first and leaves the failure in argp_error
+    Argp_Info info;
+    EXPECT(argp_info(jobs, &info) && info.set);
+    EXPECT(argp_error() == ARGP_ERROR_INVALID_NUMBER);
+    EXPECT(!argp_dump(stderr, ARGP_DUMP_TEXT));
+}
+
+// .strict converts while parsing, as if no flag were lazy
+static void test_strict(void) {
+    argp_init(test_split("prog -j many"), test_argv, .strict = true);
+    uint64_t *jobs = argp_flag_uint("j", "jobs", 1, .lazy = true);
+    EXPECT(!argp_parse_args());
+    EXPECT(argp_error() == ARGP_ERROR_INVALID_NUMBER);
+    EXPECT(*jobs == 1);
+
+    argp_init(test_split("prog -j 7"), test_argv, .strict = true);
+    jobs = argp_flag_uint("j", "jobs", 1, .lazy = true);
+    EXPECT(argp_parse_args());
+    EXPECT(*jobs == 7);
+}
+
+// the last token of a repeated flag wins, as for other flags
+static void test_repeated(void) {
+    argp_init(test_split("prog -j x -j 3"), test_argv);
+    uint64_t *jobs = argp_flag_uint("j", "jobs", 1, .lazy = true);
+    EXPECT(argp_parse_args());
+    EXPECT(argp_get_uint(jobs) == 3);
+}
+
+int main(void) {
+    test_valid();
+    test_invalid();
+    test_strict();
+    test_repeated();
+    return test_done("lazy");
+}
@@ -0,0 +1,70 @@
+// test_map.c -- how argp_flag_map splits key=value entries and handles repeated keys
+//
+//   make test
+
+#define ARGPARSE_IMPLEMENTATION
+#include "../argparse.h"
+
+#include "test.h"
+
+static void test_entries(const char *line, Argp_Map_Dup dup, Argp_Error err, const char *key, const char *want) {
+    argp_init(test_split(line), test_argv);
+    Argp_Map *env = argp_flag_map("e", "env", dup);
+    EXPECT(argp_parse_args() == (err == ARGP_NO_ERROR));
+    EXPECT(argp_error() == err);
+    if (err == ARGP_NO_ERROR) {
+        const char *value = argp_map_get(env, key);
+        EXPECT(want ? value && strcmp(value, want) == 0 : value == NULL);
+    }
+    argp_free_map(env);
+}
+
+// enough keys to grow the table a few times, every one still found
+static void test_growth(void) {
+    enum { KEYS = 300 };
+    static char entries[KEYS][16];
+    static char *argv[2 * KEYS + 2];
+    int argc = 0;
+    argv[argc++] = (char *)"prog";
+    for (int i = 0; i < KEYS; ++i) {
+        snprintf(entries[i], sizeof(entries[i]), "k%d=%d", i, i * 7);
+        argv[argc++] = (char *)"-e";
+        argv[argc++] = entries[i];
+    }
+    argv[argc] = NULL;
+    test_case = "300 keys";
+
+    argp_init(argc, argv);
+    Argp_Map *env = argp_flag_map("e", "env", ARGP_MAP_UNIQUE);
+    EXPECT(argp_parse_args());
+    EXPECT(env->size == KEYS);
+    EXPECT((env->_cap & (env->_cap - 1)) == 0 && env->size * 2 <= env->_cap);
+    for (int i = 0; i < KEYS; ++i) {
+        char key[16], want[16];
+        snprintf(key, sizeof(key), "k%d", i);
+        snprintf(want, sizeof(want), "%d", i * 7);
+        const char *value = argp_map_get(env, key);
+        EXPECT(value && strcmp(value, want) == 0);
+    }
+    EXPECT(argp_map_get(env, "k300") == NULL);
+    argp_free_map(env);
+}
+
+int main(void) {
+    test_entries("prog", ARGP_MAP_UNIQUE, ARGP_NO_ERROR, "K", NULL);
+    test_entries("prog -e K=v", ARGP_MAP_UNIQUE, ARGP_NO_ERROR, "K", "v");
+    test_entries("prog --env=K=v", ARGP_MAP_UNIQUE, ARGP_NO_ERROR, "K", "v");
+    test_entries("prog -e K=a=b", ARGP_MAP_UNIQUE, ARGP_NO_ERROR, "K", "a=b");
+    test_entries("prog -e K=", ARGP_MAP_UNIQUE, ARGP_NO_ERROR, "K", "");
+    test_entries("prog -e K=1 -e L=2", ARGP_MAP_UNIQUE, ARGP_NO_ERROR, "L", "2");
+
+    test_entries("prog -e K=1 -e K=2", ARGP_MAP_LAST_WINS, ARGP_NO_ERROR, "K", "2");
+    test_entries("prog -e K=1 -e K=2", ARGP_MAP_UNIQUE, ARGP_ERROR_DUPLICATE_KEY, NULL, NULL);
+
+    test_entries("prog -e K", ARGP_MAP_LAST_WINS, ARGP_ERROR_INVALID_ENTRY, NULL, NULL);
+    test_entries("prog -e =v", ARGP_MAP_LAST_WINS, ARGP_ERROR_INVALID_ENTRY, NULL, NULL);
+    test_entries("prog -e", ARGP_MAP_LAST_WINS, ARGP_ERROR_NO_VALUE, NULL, NULL);
+
+    test_growth();
+    return test_done("map");
+}
@@ -0,0 +1,102 @@
+// test_nargs.c -- how positional arguments declared with .nargs split the tokens
+//
+//   make test
+
+#define ARGPARSE_IMPLEMENTATION
+#include "../argparse.h"
+
+#include "test.h"
+
+// cp src+ dst
+static void test_some_then_one(const char *line, bool ok, const char *src_want, const char *dst_want) {
+    argp_init(test_split(line), test_argv);
+    Argp_List *src = argp_pos_list("src", .nargs = ARGP_NARGS_SOME);
+    char **dst = argp_pos_str("dst", NULL, .req = ARGP_REQUIRED);
+    EXPECT(argp_parse_args() == ok);
+    if (ok) {
+        EXPECT(strcmp(test_join(src), src_want) == 0);
+        EXPECT(strcmp(*dst, dst_want) == 0);
+    } else {
+        EXPECT(argp_error() == ARGP_ERROR_NO_VALUE);
+    }
+    argp_free_list(src);
+}
+
+// prog name? rest* pair{2}
+static void test_optional_any_exact(const char *line, Argp_Error err, const char *name_want,
+                                    const char *rest_want, const char *pair_want) {
+    argp_init(test_split(line), test_argv);
+    char **name = argp_pos_str("name", (char *)"-", .nargs = ARGP_NARGS_OPTIONAL);
+    Argp_List *rest = argp_pos_list("rest", .nargs = ARGP_NARGS_ANY);
+    Argp_List *pair = argp_pos_list("pair", .nargs = ARGP_NARGS(2));
+    EXPECT(argp_parse_args() == (err == ARGP_NO_ERROR));
+    EXPECT(argp_error() == err);
+    if (err == ARGP_NO_ERROR) {
+        EXPECT(strcmp(*name, name_want) == 0);
+        EXPECT(strcmp(test_join(rest), rest_want) == 0);
+        EXPECT(strcmp(test_join(pair), pair_want) == 0);
+    }
+    argp_free_list(rest);
+    argp_free_list(pair);
+}
+
+// prog pair{2}, every token past the last positional is reported when errors are collected
+static void test_too_many(bool collect) {
+    const char *line = "prog a b c d";
+    argp_init(test_split(line), test_argv, .collect_errors = collect);
+    Argp_List *pair = argp_pos_list("pair", .nargs = ARGP_NARGS(2));
+    EXPECT(!argp_parse_args());
+    EXPECT(argp_error() == ARGP_ERROR_UNKNOWN);
+
+    const Argp_Error_Record *records;
+    size_t total, count = argp_error_records(&records, &total);
+    if (collect) {
+        EXPECT(count == 2 && total == 2);
+        if (count == 2) {
+            EXPECT(strcmp(records[0].token, "c") == 0 && strcmp(records[1].token, "d") == 0);
+            EXPECT(records[0].argv_index == 3 && records[1].argv_index == 4);
+        }
+    } else {
+        EXPECT(count == 0);
+    }
+    argp_free_list(pair);
+}
+
+// prog file run target?, the required positional of the program is only checked if no
+// subcommand is selected
+static void test_subcommand(const char *line, Argp_Error err, const char *file_want, const char *target_want) {
+    argp_init(test_split(line), test_argv);
+    char **file = argp_pos_str("file", (char *)"-", .req = ARGP_REQUIRED);
+    bool *run = argp_command("run");
+    char **target = argp_pos_str("target", (char *)"-", .command = run);
+    EXPECT(argp_parse_args() == (err == ARGP_NO_ERROR));
+    EXPECT(argp_error() == err);
+    if (err == ARGP_NO_ERROR) {
+        EXPECT(strcmp(*file, file_want) == 0);
+        EXPECT(strcmp(*target, target_want) == 0);
+    }
+}
+
+int main(void) {
+    test_some_then_one("cp a dst", true, "a", "dst");
+    test_some_then_one("cp a b c dst", true, "a,b,c", "dst");
+    test_some_then_one("cp dst", false, NULL, NULL);
+    test_some_then_one("cp", false, NULL, NULL);
+
+    test_optional_any_exact("prog x y", ARGP_NO_ERROR, "-", "", "x,y");
+    test_optional_any_exact("prog n x y", ARGP_NO_ERROR, "n", "", "x,y");
+    test_optional_any_exact("prog n r s x y", ARGP_NO_ERROR, "n", "r,s", "x,y");
+    test_optional_any_exact("prog x", ARGP_ERROR_NO_VALUE, NULL, NULL, NULL);
+    test_optional_any_exact("prog", ARGP_ERROR_NO_VALUE, NULL, NULL, NULL);
+
+    test_too_many(false);
+    test_too_many(true);
+
+    test_subcommand("prog run", ARGP_NO_ERROR, "-", "-");
+    test_subcommand("prog run x", ARGP_NO_ERROR, "-", "x");
+    test_subcommand("prog f run x", ARGP_NO_ERROR, "f", "x");
+    test_subcommand("prog f", ARGP_NO_ERROR, "f", "-");
+    test_subcommand("prog", ARGP_ERROR_NO_VALUE, NULL, NULL);
+
+    return test_done("nargs");
+}
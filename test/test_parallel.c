@@ -0,0 +1,124 @@
+// test_parallel.c -- the worker pool behind .parallel lists and path checks
+//
+//   make test
+
+#define ARGPARSE_IMPLEMENTATION
+#define ARGP_CPU_COUNT 4
+#include "../argparse.h"
+
+#include "test.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <time.h>
+
+#define COUNT_MAX 100003
+#define LIST_SIZE 50000  // more than ARGP_PARALLEL_MIN
+
+static unsigned counts[COUNT_MAX];
+
+static void count_task(void *data, size_t begin, size_t end) {
+    (void)data;
+    for (size_t i = begin; i < end; ++i) __atomic_fetch_add(counts + i, 1, __ATOMIC_RELAXED);
+}
+
+// true if every index below n ran exactly once
+static bool run_once(size_t n, size_t grain) {
+    memset(counts, 0, sizeof(counts));
+    argp_parallel_for(n, grain, count_task, NULL);
+    for (size_t i = 0; i < n; ++i)
+        if (counts[i] != 1) return false;
+    return true;
+}
+
+// every index once, over many jobs on the same workers
+static void test_once(void) {
+    size_t sizes[] = {1, 2, 7, 4096, COUNT_MAX};
+    for (int round = 0; round < 50; ++round) {
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+            EXPECT(run_once(sizes[i], 1 + (size_t)round % 13));
+    }
+    EXPECT(argp_pool.started == 3);
+}
+
+static size_t steal_done;
+static bool steal_waited;  // chunk 0 saw the others finish before its time limit
+
+// chunk 0 holds the caller until every other chunk ran, the rest of its range can then only
+// have been run by the workers stealing it
+static void steal_task(void *data, size_t begin, size_t end) {
+    size_t chunks = *(size_t *)data;
+    if (begin == 0) {
+        time_t limit = time(NULL) + 10;
+        while (__atomic_load_n(&steal_done, __ATOMIC_ACQUIRE) < chunks - 1 && time(NULL) < limit)
+            sched_yield();
+        steal_waited = __atomic_load_n(&steal_done, __ATOMIC_ACQUIRE) == chunks - 1;
+        return;
+    }
+    (void)end;
+    __atomic_fetch_add(&steal_done, 1, __ATOMIC_RELEASE);
+}
+
+static void test_steal(void) {
+    size_t chunks = 64;
+    steal_done = 0;
+    argp_parallel_for(chunks, 1, steal_task, &chunks);
+    EXPECT(steal_waited && steal_done == chunks - 1);
+}
+
+// a forked child has none of the workers of its parent and starts its own
+static void test_fork(void) {
+    EXPECT(run_once(COUNT_MAX, 64));
+    pid_t pid = fork();
+    if (pid == 0) _exit(run_once(COUNT_MAX, 64) && argp_pool.started == 3 ? 0 : 1);
+    int status = 1;
+    EXPECT(pid > 0 && waitpid(pid, &status, 0) == pid);
+    EXPECT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+static char words[LIST_SIZE][24];
+static char *argv[LIST_SIZE + 2];
+
+static int list_argv(size_t bad_a, size_t bad_b) {
+    argv[0] = (char *)"prog";
+    for (size_t i = 0; i < LIST_SIZE; ++i) {
+        if (i == bad_a || i == bad_b)
+            snprintf(words[i], sizeof(words[i]), "%zux", i);
+        else
+            snprintf(words[i], sizeof(words[i]), "%llu", 18446744073709551615ull - (unsigned long long)i * 7919);
+        argv[i + 1] = words[i];
+    }
+    argv[LIST_SIZE + 1] = NULL;
+    return LIST_SIZE + 1;
+}
+
+// the parallel conversion gives the values and the first error of the serial one
+static void test_lists(void) {
+    argp_init(list_argv(SIZE_MAX, SIZE_MAX), argv);
+    Argp_Uint_List *serial = argp_pos_uint_list("n");
+    EXPECT(argp_parse_args());
+    Argp_Uint_List expected = *serial;
+
+    argp_init(list_argv(SIZE_MAX, SIZE_MAX), argv);
+    Argp_Uint_List *parallel = argp_pos_uint_list("n", .parallel = true);
+    EXPECT(argp_parse_args());
+    EXPECT(parallel->size == LIST_SIZE && expected.size == LIST_SIZE);
+    EXPECT(memcmp(parallel->items, expected.items, LIST_SIZE * sizeof(uint64_t)) == 0);
+    argp_free_uint_list(parallel);
+    argp_free_uint_list(&expected);
+
+    argp_init(list_argv(45000, 40000), argv);
+    parallel = argp_pos_uint_list("n", .parallel = true);
+    EXPECT(!argp_parse_args());
+    EXPECT(argp_error() == ARGP_ERROR_INVALID_NUMBER && argp_global_ctx.err_index == 40000);
+    argp_free_uint_list(parallel);
+}
+
+int main(void) {
+    test_once();
+    test_steal();
+    test_fork();
+    test_lists();
+    return test_done("parallel");
+}
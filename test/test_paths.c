@@ -0,0 +1,92 @@
+// test_paths.c -- batched path checks, stated one by one and in several io_uring waves
+//
+//   make test
+
+#define ARGPARSE_IMPLEMENTATION
+#define ARGP_IO_URING
+#include "../argparse.h"
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PATH_COUNT 600  // more than two waves of ARGP_URING_ENTRIES
+
+static char dir[] = "/tmp/argp_paths_XXXXXX";
+static char names[PATH_COUNT][64];
+static char *argv[PATH_COUNT + 2];
+
+// argv of the program name and count paths to files in dir, path i is replaced by bad[i] if set
+static int paths(size_t count, const char **bad) {
+    argv[0] = (char *)"prog";
+    for (size_t i = 0; i < count; ++i)
+        argv[i + 1] = bad && bad[i] ? (char *)bad[i] : names[i];
+    argv[count + 1] = NULL;
+    return (int)count + 1;
+}
+
+static const Argp_Error_Record *parse(size_t count, const char **bad, size_t *n) {
+    argp_init(paths(count, bad), argv, .collect_errors = true);
+    Argp_List *files = argp_pos_list("files", .path = ARGP_PATH_FILE | ARGP_PATH_READABLE);
+    bool ok = argp_parse_args();
+    EXPECT(ok == (bad == NULL));
+    EXPECT(!ok || files->size == count);
+    argp_free_list(files);
+
+    const Argp_Error_Record *r;
+    size_t total;
+    *n = argp_error_records(&r, &total);
+    return r;
+}
+
+// every path exists, whether the batch is stated one by one or through io_uring
+static void test_valid(void) {
+    size_t counts[] = {1, 31, 32, 256, 257, PATH_COUNT};
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i) {
+        size_t n;
+        parse(counts[i], NULL, &n);
+        EXPECT(n == 0);
+    }
+}
+
+// errors in every wave are reported with their index, in argv order
+static void test_errors(void) {
+    const char *bad[PATH_COUNT] = {0};
+    bad[3] = "/nonexistent/argp";
+    bad[300] = dir;
+    bad[599] = "/tmp/argp_paths_missing";
+
+    size_t counts[] = {8, PATH_COUNT};
+    for (size_t c = 0; c < 2; ++c) {
+        size_t n;
+        const Argp_Error_Record *r = parse(counts[c], bad, &n);
+        size_t want = counts[c] == PATH_COUNT ? 3 : 1;
+        EXPECT(n == want);
+        if (n != want) continue;
+
+        EXPECT(r[0].code == ARGP_ERROR_PATH_NOT_FOUND && r[0].index == 3);
+        EXPECT(strcmp(r[0].pos_name, "files") == 0 && strcmp(r[0].token, bad[3]) == 0);
+        if (want == 1) continue;
+        EXPECT(r[1].code == ARGP_ERROR_PATH_NOT_FILE && r[1].index == 300);
+        EXPECT(r[2].code == ARGP_ERROR_PATH_NOT_FOUND && r[2].index == 599);
+    }
+}
+
+int main(void) {
+    if (mkdtemp(dir) == NULL) return 1;
+    for (size_t i = 0; i < PATH_COUNT; ++i) {
+        snprintf(names[i], sizeof(names[i]), "%s/%zu", dir, i);
+        FILE *f = fopen(names[i], "w");
+        if (f) fclose(f);
+    }
+
+    test_valid();
+    test_errors();
+
+    for (size_t i = 0; i < PATH_COUNT; ++i)
+        unlink(names[i]);
+    rmdir(dir);
+    return test_done("paths");
+}
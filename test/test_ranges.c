@@ -0,0 +1,98 @@
+// test_ranges.c -- how range arguments are merged and how overlaps are reported
+//
+//   make test
+
+#define ARGPARSE_IMPLEMENTATION
+#include "../argparse.h"
+
+#include <stdlib.h>
+
+#include "test.h"
+
+// the ranges of a set as lo-hi, joined with commas
+static const char *ranges_str(const Argp_Ranges *ranges) {
+    static char s[256];
+    size_t n = 0;
+    s[0] = '\0';
+    for (size_t i = 0; i < ranges->size && n < sizeof(s); ++i)
+        n += (size_t)snprintf(s + n, sizeof(s) - n, "%s%llu-%llu", i ? "," : "",
+                              (unsigned long long)ranges->items[i].lo, (unsigned long long)ranges->items[i].hi);
+    return s;
+}
+
+static void test_merge(const char *line, Argp_Error err, const char *want) {
+    argp_init(test_split(line), test_argv);
+    Argp_Ranges *cpus = argp_flag_ranges("c", "cpus");
+    EXPECT(argp_parse_args() == (err == ARGP_NO_ERROR));
+    EXPECT(argp_error() == err);
+    if (err == ARGP_NO_ERROR) EXPECT(strcmp(ranges_str(cpus), want) == 0);
+    argp_free_ranges(cpus);
+}
+
+// every overlap is recorded against the entry given later, whichever side of it sorts first
+static void test_overlaps(void) {
+    argp_init(test_split("prog -c 20-30,0-10 -c 2,40 -c 25-50"), test_argv, .collect_errors = true);
+    Argp_Ranges *cpus = argp_flag_ranges("c", "cpus");
+    EXPECT(!argp_parse_args());
+    EXPECT(argp_error() == ARGP_ERROR_RANGE_OVERLAP);
+
+    const Argp_Error_Record *records;
+    size_t total;
+    size_t n = argp_error_records(&records, &total);
+    EXPECT(n == 2 && total == 2);
+    if (n == 2) {
+        EXPECT(records[0].code == ARGP_ERROR_RANGE_OVERLAP);
+        EXPECT(records[0].argv_index == 4 && strcmp(records[0].token, "2,40") == 0);
+        EXPECT(records[0].index == 0 && strcmp(records[0].long_name, "cpus") == 0);
+        EXPECT(records[1].argv_index == 6 && strcmp(records[1].token, "25-50") == 0);
+        EXPECT(records[1].index == 0);
+    }
+    argp_free_ranges(cpus);
+}
+
+static void test_queries(void) {
+    argp_init(test_split("prog 3-5,64,130-131"), test_argv);
+    Argp_Ranges *ids = argp_pos_ranges("ids");
+    EXPECT(argp_parse_args());
+
+    EXPECT(!argp_ranges_contains(ids, 2) && argp_ranges_contains(ids, 3) && argp_ranges_contains(ids, 5));
+    EXPECT(!argp_ranges_contains(ids, 6) && argp_ranges_contains(ids, 64) && !argp_ranges_contains(ids, 132));
+
+    char seen[64] = "";
+    size_t n = 0;
+    uint64_t v;
+    Argp_Ranges_Iter it = {.ranges = ids};
+    while (argp_ranges_next(&it, &v)) n += (size_t)snprintf(seen + n, sizeof(seen) - n, "%llu ", (unsigned long long)v);
+    EXPECT(strcmp(seen, "3 4 5 64 130 131 ") == 0);
+
+    size_t words;
+    uint64_t *bitmap = argp_ranges_bitmap(ids, &words);
+    EXPECT(bitmap && words == 3);
+    if (bitmap && words == 3) {
+        EXPECT(bitmap[0] == 0x38 && bitmap[1] == 1 && bitmap[2] == 0xc);
+    }
+    free(bitmap);
+    argp_free_ranges(ids);
+}
+
+int main(void) {
+    test_merge("prog", ARGP_NO_ERROR, "");
+    test_merge("prog -c 7", ARGP_NO_ERROR, "7-7");
+    test_merge("prog -c 8-9,0-3", ARGP_NO_ERROR, "0-3,8-9");
+    // adjacent ranges become one, also across repeated flags
+    test_merge("prog -c 0-3,4-7 -c 8", ARGP_NO_ERROR, "0-8");
+    test_merge("prog --cpus=18446744073709551614-18446744073709551615 -c 0", ARGP_NO_ERROR,
+               "0-0,18446744073709551614-18446744073709551615");
+
+    test_merge("prog -c 0-3,3", ARGP_ERROR_RANGE_OVERLAP, NULL);
+    test_merge("prog -c 0-10 -c 5-6", ARGP_ERROR_RANGE_OVERLAP, NULL);
+    test_merge("prog -c 5-3", ARGP_ERROR_INVALID_RANGE, NULL);
+    test_merge("prog -c 1-", ARGP_ERROR_INVALID_NUMBER, NULL);
+    test_merge("prog -c 1,,2", ARGP_ERROR_INVALID_NUMBER, NULL);
+    test_merge("prog -c 18446744073709551616", ARGP_ERROR_INTEGER_OVERFLOW, NULL);
+    test_merge("prog -c", ARGP_ERROR_NO_VALUE, NULL);
+
+    test_overlaps();
+    test_queries();
+    return test_done("ranges");
+}
@@ -0,0 +1,80 @@
+// test_reload.c -- generations published by argp_reload and when replaced ones are freed
+//
+//   make test
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+// generation being watched, set once ARGP_FREE releases it
+static const void *watched;
+static bool watched_freed;
+
+static void test_free(void *p) {
+    if (p && p == watched) watched_freed = true;
+    free(p);
+}
+
+#define ARGP_FREE test_free
+#define ARGPARSE_IMPLEMENTATION
+#include "../argparse.h"
+
+#include "test.h"
+
+static void watch(const Argp_Generation *gen) {
+    watched = gen;
+    watched_freed = false;
+}
+
+int main(void) {
+    argp_init(test_split("prog -j 2 -t a -t b"), test_argv);
+    uint64_t *jobs = argp_flag_uint("j", "jobs", 1);
+    Argp_List *tags = argp_flag_list("t", "tag");
+    EXPECT(argp_parse_args());
+    EXPECT(argp_current() == NULL);
+    EXPECT(argp_publish());
+
+    const Argp_Generation *first = argp_current();
+    EXPECT(first && *(const uint64_t *)argp_get(first, jobs) == 2);
+    EXPECT(((const Argp_List *)argp_get(first, tags))->size == 2);
+
+    Argp_Rcu_Reader reader, idle;
+    EXPECT(argp_rcu_register(&reader));
+    EXPECT(argp_rcu_register(&idle));
+
+    // the reader still holds the first generation, so it outlives the reload
+    // argv[0] need not be the name given to argp_init
+    watch(first);
+    char *args[] = {(char *)"./bin/prog", (char *)"-j", (char *)"5", (char *)"-t", (char *)"c", NULL};
+    EXPECT(argp_reload(5, args));
+    const Argp_Generation *second = argp_current();
+    EXPECT(second != first && *(const uint64_t *)argp_get(second, jobs) == 5);
+    EXPECT(!watched_freed);
+    EXPECT(*(const uint64_t *)argp_get(first, jobs) == 2);
+    EXPECT(strcmp(((const Argp_List *)argp_get(first, tags))->items[1], "b") == 0);
+
+    // freed once every registered reader has been quiescent since the swap
+    argp_rcu_quiescent(&reader);
+    argp_rcu_reclaim();
+    EXPECT(!watched_freed);
+    argp_rcu_unregister(&idle);
+    argp_rcu_reclaim();
+    EXPECT(watched_freed);
+
+    // a failed reload keeps the generation and the values of the last good one
+    watch(second);
+    char *bad[] = {(char *)"prog", (char *)"-j", (char *)"x", NULL};
+    EXPECT(!argp_reload(3, bad));
+    EXPECT(argp_error() == ARGP_ERROR_INVALID_NUMBER);
+    EXPECT(argp_current() == second && !watched_freed);
+    EXPECT(*jobs == 5 && tags->size == 1 && strcmp(tags->items[0], "c") == 0);
+
+    // with no reader holding it, a replaced generation is freed by the publish itself
+    argp_rcu_unregister(&reader);
+    char *third[] = {(char *)"prog", NULL};
+    EXPECT(argp_reload(1, third));
+    EXPECT(watched_freed);
+    EXPECT(*jobs == 1 && tags->size == 0);
+
+    // the values of the first parse were freed by the library, the leak checker would say otherwise
+    return test_done("reload");
+}
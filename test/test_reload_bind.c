@@ -0,0 +1,64 @@
+// test_reload_bind.c -- structs bound with argp_bind across good and failed reloads
+//
+//   make test
+
+#define ARGPARSE_IMPLEMENTATION
+#include "../argparse.h"
+
+#include <stdlib.h>
+
+#include "test.h"
+
+typedef struct {
+    uint64_t jobs;
+    char *out;
+    Argp_List tags;
+    Argp_List files;
+} Config;
+
+static char path[] = "/tmp/test_reload_bind.XXXXXX";
+
+static bool test_reload(const char *content) {
+    FILE *f = fopen(path, "w");
+    fputs(content, f);
+    fclose(f);
+    return argp_reload_file(path);
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    int fd = mkstemp(path);
+    if (fd < 0) return 1;
+    close(fd);
+
+    char *args[] = {argv[0], "-t", "first", "a", NULL};
+    Config cfg = {0};
+    argp_init(4, args);
+    argp_flag_uint("j", NULL, 1, .bind = ARGP_BIND(Config, jobs));
+    argp_flag_str("o", NULL, "a.out", .bind = ARGP_BIND(Config, out));
+    argp_flag_list("t", NULL, .bind = ARGP_BIND(Config, tags));
+    argp_pos_list("files", .bind = ARGP_BIND(Config, files));
+    argp_bind(&cfg);
+    EXPECT(argp_parse_args());
+    EXPECT(cfg.tags.size == 1 && strcmp(cfg.tags.items[0], "first") == 0);
+
+    EXPECT(test_reload("-j 4 -o out -t x -t y b c\n"));
+    EXPECT(cfg.jobs == 4 && strcmp(cfg.out, "out") == 0);
+    EXPECT(cfg.tags.size == 2 && strcmp(cfg.tags.items[1], "y") == 0);
+    EXPECT(cfg.files.size == 2 && strcmp(cfg.files.items[1], "c") == 0);
+
+    // the previous values are bound again and stay readable
+    EXPECT(!test_reload("-j 8 -t z d -j nope\n"));
+    EXPECT(argp_error() == ARGP_ERROR_INVALID_NUMBER);
+    EXPECT(cfg.jobs == 4 && strcmp(cfg.out, "out") == 0);
+    EXPECT(cfg.tags.size == 2 && strcmp(cfg.tags.items[0], "x") == 0);
+    EXPECT(cfg.files.size == 2 && strcmp(cfg.files.items[0], "b") == 0);
+
+    EXPECT(test_reload("-t w\n"));
+    EXPECT(cfg.jobs == 1 && strcmp(cfg.out, "a.out") == 0);
+    EXPECT(cfg.tags.size == 1 && strcmp(cfg.tags.items[0], "w") == 0);
+    EXPECT(cfg.files.size == 0);
+
+    unlink(path);
+    return test_done("reload bind");
+}
@@ -0,0 +1,127 @@
+// test_snapshot.c -- values written with argp_snapshot_write load back in a process with the same spec
+//
+//   make test
+
+#define ARGPARSE_IMPLEMENTATION
+#include "../argparse.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "test.h"
+
+static const char *levels[] = {"low", "mid", "high"};
+
+typedef struct {
+    uint64_t *jobs;
+    char **out;
+    size_t *level;
+    Argp_List *tags;
+    Argp_Map *env;
+    char **file;
+} Spec;
+
+static Spec spec(void) {
+    Spec s;
+    s.jobs = argp_flag_uint("j", "jobs", 1);
+    s.out = argp_flag_str("o", "out", (char *)"a.out");
+    s.level = argp_flag_enum("l", "level", levels, 3, 0);
+    s.tags = argp_flag_list("t", "tag");
+    s.env = argp_flag_map("e", "env", ARGP_MAP_LAST_WINS);
+    s.file = argp_pos_str("file", (char *)"-");
+    return s;
+}
+
+static void free_spec(Spec *s) {
+    argp_free_list(s->tags);
+    argp_free_map(s->env);
+}
+
+// writes a snapshot of line into a temporary file and returns its descriptor at offset 0
+static int write_snapshot(const char *line) {
+    FILE *f = tmpfile();
+    int fd = dup(fileno(f));
+    fclose(f);
+    argp_init(test_split(line), test_argv);
+    Spec s = spec();
+    EXPECT(argp_parse_args());
+    EXPECT(argp_snapshot_write(fd));
+    EXPECT(lseek(fd, 0, SEEK_SET) == 0);
+    free_spec(&s);
+    return fd;
+}
+
+static void test_round_trip(void) {
+    int fd = write_snapshot("prog -j 8 -o x -l high -t a -t b -e K=v in.txt");
+    argp_init(test_split("child"), test_argv);
+    Spec s = spec();
+    EXPECT(argp_snapshot_load(fd));
+    EXPECT(*s.jobs == 8);
+    EXPECT(strcmp(*s.out, "x") == 0);
+    EXPECT(*s.level == 2);
+    EXPECT(strcmp(test_join(s.tags), "a,b") == 0);
+    EXPECT(argp_map_get(s.env, "K") && strcmp(argp_map_get(s.env, "K"), "v") == 0);
+    EXPECT(strcmp(*s.file, "in.txt") == 0);
+    Argp_Info info;
+    EXPECT(argp_info(s.jobs, &info) && info.set && info.source == ARGP_SOURCE_SNAPSHOT);
+    free_spec(&s);
+    close(fd);
+}
+
+// arguments left at their default in the parent stay at the default of the child
+static void test_defaults(void) {
+    int fd = write_snapshot("prog -j 3");
+    argp_init(test_split("child"), test_argv);
+    Spec s = spec();
+    EXPECT(argp_snapshot_load(fd));
+    EXPECT(*s.jobs == 3);
+    EXPECT(strcmp(*s.out, "a.out") == 0);
+    EXPECT(s.tags->size == 0);
+    Argp_Info info;
+    EXPECT(argp_info(s.out, &info) && !info.set && info.source == ARGP_SOURCE_DEFAULT);
+    free_spec(&s);
+    close(fd);
+}
+
+// a different spec is refused and the parsed values are left as they were
+static void test_spec_mismatch(void) {
+    int fd = write_snapshot("prog -j 8");
+    argp_init(test_split("child -j 2"), test_argv);
+    uint64_t *jobs = argp_flag_uint("j", "jobs", 1);
+    EXPECT(argp_parse_args());
+    EXPECT(!argp_snapshot_load(fd));
+    EXPECT(argp_error() == ARGP_ERROR_SNAPSHOT);
+    EXPECT(*jobs == 2);
+    close(fd);
+}
+
+// every prefix of a snapshot is refused
+static void test_truncated(void) {
+    int fd = write_snapshot("prog -j 8 -t a -e K=v x");
+    off_t size = lseek(fd, 0, SEEK_END);
+    EXPECT(size > 0);
+    char *blob = malloc((size_t)size);
+    EXPECT(pread(fd, blob, (size_t)size, 0) == size);
+    for (off_t n = 0; n < size; ++n) {
+        FILE *f = tmpfile();
+        int part = fileno(f);
+        EXPECT(write(part, blob, (size_t)n) == n);
+        lseek(part, 0, SEEK_SET);
+        argp_init(test_split("child"), test_argv);
+        Spec s = spec();
+        EXPECT(!argp_snapshot_load(part));
+        EXPECT(*s.jobs == 1);
+        free_spec(&s);
+        fclose(f);
+    }
+    free(blob);
+    close(fd);
+}
+
+int main(void) {
+    test_round_trip();
+    test_defaults();
+    test_spec_mismatch();
+    test_truncated();
+    return test_done("snapshot");
+}
@@ -0,0 +1,100 @@
+// test_sorted.c -- sorted lists are deduplicated, front-coded and searchable
+//
+//   make test
+
+#define ARGPARSE_IMPLEMENTATION
+#include "../argparse.h"
+
+#include <stdlib.h>
+
+#include "test.h"
+
+// every entry of a sorted list in order, joined with commas
+static const char *sorted_join(const Argp_Sorted_List *list) {
+    static char s[4096];
+    char entry[256];
+    size_t n = 0;
+    s[0] = '\0';
+    Argp_Sorted_Iter it = {.list = list, .buf = entry};
+    while (argp_sorted_next(&it) && n < sizeof(s))
+        n += (size_t)snprintf(s + n, sizeof(s) - n, "%s%s", n ? "," : "", entry);
+    return s;
+}
+
+static void test_order(void) {
+    argp_init(test_split("prog -s pear -s apple -s pear -s apples -s app @@x"), test_argv);
+    Argp_Sorted_List *words = argp_flag_sorted_list("s", NULL);
+    Argp_Sorted_List *rest = argp_pos_sorted_list("rest");
+    EXPECT(argp_parse_args());
+    EXPECT(strcmp(sorted_join(words), "app,apple,apples,pear") == 0);
+    EXPECT(words->count == 4 && words->max_len == 6);
+    // @@ escapes a leading @
+    EXPECT(strcmp(sorted_join(rest), "@x") == 0);
+
+    EXPECT(argp_sorted_contains(words, "apple") && argp_sorted_contains(words, "app"));
+    EXPECT(!argp_sorted_contains(words, "ap") && !argp_sorted_contains(words, "applez"));
+    EXPECT(!argp_sorted_contains(words, "") && !argp_sorted_contains(words, "zebra"));
+    argp_free_sorted_list(words);
+    argp_free_sorted_list(rest);
+}
+
+// enough entries read from a file for several blocks
+static void test_blocks(void) {
+    enum { ENTRIES = 100 };
+    char path[] = "/tmp/test_sorted.XXXXXX";
+    int fd = mkstemp(path);
+    EXPECT(fd >= 0);
+    FILE *f = fdopen(fd, "w");
+    for (int i = ENTRIES; i-- > 0;) fprintf(f, "host-%03d.example\n", i);
+    fprintf(f, "host-007.example\n");
+    fclose(f);
+
+    static char line[128];
+    snprintf(line, sizeof(line), "prog -s @%s -s host-100.example", path);
+    argp_init(test_split(line), test_argv);
+    Argp_Sorted_List *hosts = argp_flag_sorted_list("s", NULL);
+    EXPECT(argp_parse_args());
+    unlink(path);
+
+    EXPECT(hosts->count == ENTRIES + 1 && hosts->max_len == strlen("host-000.example"));
+    EXPECT(argp_sorted_block_count(hosts) == (ENTRIES + 1 + ARGP_SORTED_BLOCK - 1) / ARGP_SORTED_BLOCK);
+
+    char want[32], got[32];
+    for (size_t i = 0; i <= ENTRIES; ++i) {
+        snprintf(want, sizeof(want), "host-%03zu.example", i);
+        EXPECT(argp_sorted_get(hosts, i, got) && strcmp(got, want) == 0);
+        EXPECT(argp_sorted_contains(hosts, want));
+    }
+    EXPECT(!argp_sorted_get(hosts, ENTRIES + 1, got));
+    EXPECT(!argp_sorted_contains(hosts, "host-101.example"));
+
+    // seeking lands on the first entry of a block
+    Argp_Sorted_Iter it = {.list = hosts, .buf = got};
+    argp_sorted_seek(&it, 3);
+    snprintf(want, sizeof(want), "host-%03d.example", 3 * ARGP_SORTED_BLOCK);
+    EXPECT(argp_sorted_next(&it) && strcmp(got, want) == 0);
+    argp_sorted_seek(&it, argp_sorted_block_count(hosts));
+    EXPECT(!argp_sorted_next(&it));
+    argp_free_sorted_list(hosts);
+}
+
+static void test_empty_and_missing(void) {
+    argp_init(test_split("prog"), test_argv);
+    Argp_Sorted_List *words = argp_flag_sorted_list("s", NULL);
+    EXPECT(argp_parse_args());
+    EXPECT(words->count == 0 && argp_sorted_block_count(words) == 0);
+    EXPECT(!argp_sorted_contains(words, "a"));
+    EXPECT(strcmp(sorted_join(words), "") == 0);
+
+    argp_init(test_split("prog -s @/nonexistent/list"), test_argv);
+    words = argp_flag_sorted_list("s", NULL);
+    EXPECT(!argp_parse_args());
+    EXPECT(argp_error() == ARGP_ERROR_PATH_NOT_FOUND);
+}
+
+int main(void) {
+    test_order();
+    test_blocks();
+    test_empty_and_missing();
+    return test_done("sorted");
+}